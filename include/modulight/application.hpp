@@ -9,6 +9,7 @@
 #include <modulight/common/moduledescription.hpp>
 #include <modulight/common/network.hpp>
 #include <modulight/common/dynamicrequest.hpp>
+#include <modulight/common/queuepolicy.hpp>
 
 #include <modulight/master/process.hpp>
 #include <modulight/master/masterconnection.hpp>
@@ -121,10 +122,39 @@ public:
      * @param processB The destination process
      * @param portB The destination port name
      * @param lossyConnection if set to true, the connection will be lossy. Otherwise, it will be lossless
+     * @param queueBound The maximum number of messages queued for the destination on a lossless connection. 0 means unbounded
+     * @param queuePolicy What is done with a new message once the queue is full. Only used if queueBound is positive
+     * @param msTimeToLive Messages older than this, in milliseconds, are dropped instead of being read. 0 means they never expire
+     * @param decimation Only one message out of decimation is sent to the destination. 1 means every message
+     * @param maxFrequency The maximum number of messages sent to the destination per second. 0 means unlimited
+     *
+     * If both processes run on the same host, the connection uses Unix domain sockets and
+     * large messages are exchanged through a shared memory ring owned by the source process.<br/>
+     * <br/>
+     * By default, the messages of a lossless connection are queued without limit, so a slow destination makes the source memory grow.
+     * A bounded connection queues at most queueBound messages on the source side (and as many in transit),
+     * see Module::droppedMessageCount for the messages dropped by the QueuePolicy::DROP_OLDEST and QueuePolicy::DROP_NEWEST policies.<br/>
+     * With QueuePolicy::ADAPTIVE, the connection is lossless until the destination lags a whole queue behind.
+     * It then becomes lossy, only the newest message being kept, until the destination has read half of the messages in transit.
+     * The switch is done by the source alone, without any dynamic order.
+     * Bounded connections never use the shared memory ring.<br/>
+     * <br/>
+     * With a time to live, the destination drops the messages sent too long ago before they are read,
+     * and the source does not push a stale message on lossy and bounded connections.
+     * Messages are timed with the clock of each host, which must be synchronized (NTP) for the connections between hosts.
+     * See Module::expiredMessageCount.<br/>
+     * <br/>
+     * Decimation and maximum frequency sample the messages sent to the destination, for example for a monitoring module.
+     * The source skips the other messages for this destination alone, they are never sent to it.
+     * Received messages keep their port iteration numbers, so the destination knows which ones it missed.
+     * Sampled connections are credit based : a lossless one is bounded, with a queue of 64 messages if queueBound is 0.
+     * Each batch (see Module::setBatching) is sampled as a whole.
      */
     void connect(user_interface::Process * processA, const QString & portA,
                  user_interface::Process * processB, const QString & portB,
-                 bool lossyConnection = false);
+                 bool lossyConnection = false, int queueBound = 0,
+                 QueuePolicy::QueuePolicy queuePolicy = QueuePolicy::BLOCK, int msTimeToLive = 0,
+                 int decimation = 1, double maxFrequency = 0);
 
     /**
      * @brief Connects an input port to an output port
@@ -133,12 +163,19 @@ public:
      * @param processB the destination parallel process
      * @param portB the destination port name
      * @param lossyConnection if set to true, the connection will be lossy. Otherwise, it will be lossless
+     * @param queueBound The maximum number of messages queued for the destination on a lossless connection. 0 means unbounded
+     * @param queuePolicy What is done with a new message once the queue is full. Only used if queueBound is positive
+     * @param msTimeToLive Messages older than this, in milliseconds, are dropped instead of being read. 0 means they never expire
+     * @param decimation Only one message out of decimation is sent to the destination. 1 means every message
+     * @param maxFrequency The maximum number of messages sent to the destination per second. 0 means unlimited
      *
      * The connection will be of type 1-n, which means the source process will be connected to every instance of the parallel process.
      */
     void connect(user_interface::Process *processA, const QString &portA,
                  user_interface::ParallelProcess *processB, const QString &portB,
-                 bool lossyConnection = false);
+                 bool lossyConnection = false, int queueBound = 0,
+                 QueuePolicy::QueuePolicy queuePolicy = QueuePolicy::BLOCK, int msTimeToLive = 0,
+                 int decimation = 1, double maxFrequency = 0);
 
     /**
      * @brief Connects an input port to an output port
@@ -147,12 +184,19 @@ public:
      * @param processB the destination process
      * @param portB the destination port name
      * @param lossyConnection if set to true, the connection will be lossy. Otherwise, it will be lossless
+     * @param queueBound The maximum number of messages queued for the destination on a lossless connection. 0 means unbounded
+     * @param queuePolicy What is done with a new message once the queue is full. Only used if queueBound is positive
+     * @param msTimeToLive Messages older than this, in milliseconds, are dropped instead of being read. 0 means they never expire
+     * @param decimation Only one message out of decimation is sent to the destination. 1 means every message
+     * @param maxFrequency The maximum number of messages sent to the destination per second. 0 means unlimited
      *
      * The connection will be of type n-1, which means every instance of the parallel process will be connected to the destination process.
      */
     void connect(user_interface::ParallelProcess *processA, const QString &portA,
                  user_interface::Process *processB, const QString &portB,
-                 bool lossyConnection = false);
+                 bool lossyConnection = false, int queueBound = 0,
+                 QueuePolicy::QueuePolicy queuePolicy = QueuePolicy::BLOCK, int msTimeToLive = 0,
+                 int decimation = 1, double maxFrequency = 0);
 
     ///@}
 
@@ -340,6 +384,36 @@ public:
      */
     void setArgument(user_interface::ParallelProcess * process, const QString & arg, double value);
 
+    /**
+     * @brief Limits the rate of the messages sent on an output port of a process
+     * @param process The process
+     * @param port The output port name
+     * @param messagesPerSecond The maximum number of messages sent per second. 0 removes this limit
+     * @param bytesPerSecond The maximum number of bytes sent per second. 0 removes this limit
+     * @param policy What to do with a message sent while the limit is reached (BLOCK, DROP_OLDEST or DROP_NEWEST)
+     *
+     * The limit is given to the process as arguments, and applied when it initializes.<br/>
+     * <br/>
+     * See also : Module::setRateLimit()
+     */
+    void setRateLimit(user_interface::Process * process, const QString & port, double messagesPerSecond, double bytesPerSecond,
+                      QueuePolicy::QueuePolicy policy = QueuePolicy::BLOCK);
+
+    /**
+     * @brief Limits the rate of the messages sent on an output port of a parallel process
+     * @param process The process
+     * @param port The output port name
+     * @param messagesPerSecond The maximum number of messages sent per second. 0 removes this limit
+     * @param bytesPerSecond The maximum number of bytes sent per second. 0 removes this limit
+     * @param policy What to do with a message sent while the limit is reached (BLOCK, DROP_OLDEST or DROP_NEWEST)
+     *
+     * The limit applies to every instance of the parallel process, each one on its own.<br/>
+     * <br/>
+     * See also : Module::setRateLimit()
+     */
+    void setRateLimit(user_interface::ParallelProcess * process, const QString & port, double messagesPerSecond, double bytesPerSecond,
+                      QueuePolicy::QueuePolicy policy = QueuePolicy::BLOCK);
+
     ///@}
 
 private:
@@ -374,6 +448,12 @@ private:
     bool isCurrentlyConnected(int pidA, const QString & portA,
                               int pidB, const QString & portB);
 
+    bool areColocated(const Process & a, const Process & b) const;
+    QString ipcEndpoint(const Process & source, const QString & sourcePort, bool lossy, const Process & destination) const;
+    bool usesSharedMemory(const Process & source, const QString & sourcePort, const Process & destination) const;
+    void steeringEndpoint(const Process & source, const QString & sourcePort, const Process & destination,
+                          const QString & destinationPort, quint16 & port, QString & ipc) const;
+
     Process & processByNameAndInstance(const QString & name, int instance);
     const Process & processByNameAndInstance(const QString & name, int instance) const;
 
@@ -3,6 +3,8 @@
 
 #include <QString>
 
+#include <modulight/common/queuepolicy.hpp>
+
 namespace modulight
 {
 /**
@@ -29,11 +31,21 @@ struct DynamicOrder
 
     // These are used when connections are being altered (ACCEPT, CONNECT, INPUT_DISCONNECT, OUTPUT_DISCONNECT)
     bool lossyConnection;
+    bool sharedMemory; // ACCEPT and CONNECT : both modules run on the same host, large messages are exchanged through a shared memory ring
     QString localPortName;
     QString remoteAbbrevName;
     QString remoteIP;
     quint16 remotePort;
     quint16 syncPort;
+    QString remoteIpc; // ipc:// endpoint of the remote port if it runs on the same host, empty otherwise (TCP is used)
+    quint32 remoteId; // Numeric id of the remote port (see outputPortId() on CONNECT and INPUT_DISCONNECT, inputPortId() on ACCEPT)
+    int queueBound; // ACCEPT and CONNECT, lossless connections only : maximum number of queued messages, 0 => unbounded
+    QueuePolicy::QueuePolicy queuePolicy; // ACCEPT : what the producer does once the bounded queue is full
+    int msTimeToLive; // ACCEPT and CONNECT : messages older than this are dropped, 0 => they never expire
+    int decimation; // ACCEPT : only one message out of decimation is sent to the remote, 1 => every message
+    double maxFrequency; // ACCEPT : maximum number of messages sent to the remote per second, 0 => unlimited
+    quint16 steeringPort; // CONNECT : TCP port number of the remote steering lane, 0 if the connection has none
+    QString steeringIpc; // CONNECT : ipc:// endpoint of the remote steering lane if it runs on the same host, empty otherwise
 };
 
 struct DynamicOrderSequence
@@ -4,6 +4,8 @@
 #include <QString>
 #include <QMap>
 
+#include <modulight/common/queuepolicy.hpp>
+
 namespace modulight
 {
 /**
@@ -40,9 +42,17 @@ struct DynamicRequest
     QString destinationPort;        // ADD_CONNECTION, REMOVE_CONNECTION
 
     bool lossyConnection;           // ADD_CONNECTION
+    int queueBound;                 // ADD_CONNECTION
+    QueuePolicy::QueuePolicy queuePolicy; // ADD_CONNECTION
+    int msTimeToLive;               // ADD_CONNECTION
+    int decimation;                 // ADD_CONNECTION
+    double maxFrequency;            // ADD_CONNECTION
 
     QString moduleName;             // REMOVE_MODULE
     int moduleInstance;             // REMOVE_MODULE
+
+    DynamicRequest() : lossyConnection(false), queueBound(0), queuePolicy(QueuePolicy::BLOCK), msTimeToLive(0),
+        decimation(1), maxFrequency(0) {}
 };
 
 struct DynamicRequestSequence
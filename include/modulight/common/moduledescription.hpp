@@ -13,12 +13,19 @@ struct ModuleDescription
     {
         quint16 losslessPort; // tcp port number
         quint16 lossyPort; // tcp port number
+        int index; // index of the port within its module, see outputPortId()
+        QString losslessIpc; // ipc:// endpoint of the lossless socket, empty if the module could not bind one
+        QString lossyIpc; // ipc:// endpoint of the lossy socket, empty if the module could not bind one
+        QString sharedMemoryIpc; // ipc:// endpoint of the shared memory descriptors socket, empty if unavailable
+        quint16 steeringPort; // tcp port number of the steering lane, 0 if the port has none
+        QString steeringIpc; // ipc:// endpoint of the steering lane, empty if there is none or the module could not bind one
     };
 
     QString name;
     QString ip;
     quint16 syncPort;
     QVector<QString> inputPorts;
+    QVector<QString> steeringInputPorts; // Input ports which have a steering lane
     QMap<QString, OutputPort> outputPorts;
 };
 }
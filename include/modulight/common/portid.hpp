@@ -0,0 +1,31 @@
+#ifndef PORTID_HPP
+#define PORTID_HPP
+
+#include <QtGlobal>
+
+namespace modulight
+{
+/**
+ * @brief Builds the numeric identifier of an output port, which is carried in the stamp of every message sent on it
+ * @param processId The id given by the master to the process owning the port
+ * @param portIndex The index of the output port within its module
+ * @return The output port identifier, unique within an application
+ */
+inline quint32 outputPortId(int processId, int portIndex)
+{
+    return ((quint32)processId << 16) | ((quint32)portIndex & 0x7fff);
+}
+
+/**
+ * @brief Builds the numeric identifier of an input port, which is carried in its lossy requests
+ * @param processId The id given by the master to the process owning the port
+ * @param portIndex The index of the input port within its module
+ * @return The input port identifier, unique within an application and never equal to an output port one
+ */
+inline quint32 inputPortId(int processId, int portIndex)
+{
+    return ((quint32)processId << 16) | 0x8000 | ((quint32)portIndex & 0x7fff);
+}
+}
+
+#endif // PORTID_HPP
@@ -0,0 +1,21 @@
+#ifndef QUEUEPOLICY_HPP
+#define QUEUEPOLICY_HPP
+
+namespace modulight
+{
+    namespace QueuePolicy
+    {
+        /**
+         * @brief Represents what a bounded connection does when its queue is full (see Application::connect)
+         */
+        enum QueuePolicy
+        {
+            BLOCK, //!< Module::send blocks until the destination has read enough messages
+            DROP_OLDEST, //!< The oldest queued message is dropped to make room for the new one
+            DROP_NEWEST, //!< The new message is dropped
+            ADAPTIVE //!< The connection becomes lossy (only the newest message is kept) until the destination has caught up
+        };
+    }
+}
+
+#endif // QUEUEPOLICY_HPP
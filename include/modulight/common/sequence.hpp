@@ -4,6 +4,8 @@
 #include <QString>
 #include <QVector>
 
+#include <modulight/common/queuepolicy.hpp>
+
 namespace modulight
 {
 struct Connection
@@ -11,12 +13,22 @@ struct Connection
     // The inputport (sub) will subscribe to the outputport (pub)
     bool isConnect; // true -> connect, false -> useless arguments except localPortName and remoteAbbrevName
     bool isLossy;
+    bool isSharedMemory; // Both modules run on the same host, large messages are exchanged through a shared memory ring
 
     QString localPortName; // Modulight port, not a TCP one
     QString remoteAbbrevName; // For example, A0:out
     QString remoteIP;
     quint16 remotePort; // TCP port number
     quint16 syncPort; // TCP port number
+    QString remoteIpc; // ipc:// endpoint of the remote port if it runs on the same host, empty otherwise (TCP is used)
+    quint32 remoteId; // Numeric id of the remote port (see outputPortId() on connect, inputPortId() on accept)
+    int queueBound; // Lossless connections only : maximum number of queued messages, 0 => unbounded
+    QueuePolicy::QueuePolicy queuePolicy; // What the producer does once the bounded queue is full (accept only)
+    int msTimeToLive; // Messages older than this are dropped, 0 => they never expire
+    int decimation; // Accept only : only one message out of decimation is sent to the remote, 1 => every message
+    double maxFrequency; // Accept only : maximum number of messages sent to the remote per second, 0 => unlimited
+    quint16 steeringPort; // Connect only : TCP port number of the remote steering lane, 0 if the connection has none
+    QString steeringIpc; // Connect only : ipc:// endpoint of the remote steering lane if it runs on the same host, empty otherwise
 };
 
 struct Sequence
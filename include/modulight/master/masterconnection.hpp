@@ -4,6 +4,7 @@
 #include <QString>
 
 #include <modulight/master/process.hpp>
+#include <modulight/common/queuepolicy.hpp>
 
 namespace modulight
 {
@@ -17,6 +18,22 @@ struct MasterConnection
 
     bool lossy;
 
+    int queueBound; // 0 => unbounded
+    QueuePolicy::QueuePolicy queuePolicy;
+
+    int msTimeToLive; // 0 => messages never expire
+
+    int decimation; // Only one message out of decimation is sent, 1 => every message
+    double maxFrequency; // Messages per second, 0 => unlimited
+
+    static const int SAMPLED_QUEUE_BOUND = 64; // Queue bound of the sampled lossless connections which do not give one
+
+    MasterConnection() : lossy(false), queueBound(0), queuePolicy(QueuePolicy::BLOCK), msTimeToLive(0), decimation(1), maxFrequency(0) {}
+
+    bool isSampled() const { return decimation > 1 || maxFrequency > 0; } //! Sampled connections are lossy or bounded (credit based)
+
+    bool isBounded() const { return !lossy && queueBound > 0; } //! Bounded connections use the lossy sockets (credit based)
+
     bool operator==(const MasterConnection & c);
 };
 }
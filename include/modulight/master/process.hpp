@@ -26,6 +26,7 @@ struct Process
 
     ModuleDescription description;
     int instanceNumber;
+    QString host; // The host the process had been spawned on
 
     Process();
 
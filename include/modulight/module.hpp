@@ -1,17 +1,26 @@
 #ifndef MODULE_HPP
 #define MODULE_HPP
 
+#include <atomic>
 #include <iostream>
 
 #include <mpi.h>
 #include <zmq.hpp>
 
 #include <QMap>
+#include <QMutex>
+#include <QTime>
 
 #include <modulight/module/port.hpp>
+#include <modulight/module/porthandle.hpp>
 #include <modulight/module/messagereader.hpp>
 #include <modulight/module/messagewriter.hpp>
 #include <modulight/module/modulestate.hpp>
+#include <modulight/module/waitmode.hpp>
+#include <modulight/module/sendmode.hpp>
+#include <modulight/module/portflag.hpp>
+#include <modulight/module/joinpolicy.hpp>
+#include <modulight/module/progressthread.hpp>
 
 #include <modulight/common/sequence.hpp>
 #include <modulight/common/arguments.hpp>
@@ -187,18 +196,39 @@ public:
     /**
      * @brief Add an input port
      * @param name The input port name
+     * @param flags The port options, a combination of PortFlag::PortFlag values
+     * @return A handle on the added port, which is invalid if the port could not be added
      *
+     * With PortFlag::STEERING_LANE, the port receives the steering messages of the output ports which have a lane too
+     * (see sendSteering()).<br/>
      * Please note this method can only be called before the initialize method call.
      */
-    void addInputPort(const QString & name);
+    PortHandle addInputPort(const QString & name, int flags = PortFlag::NONE);
 
     /**
      * @brief Adds an output port
      * @param name The output port name
+     * @param flags The port options, a combination of PortFlag::PortFlag values
+     * @return A handle on the added port, which is invalid if the port could not be added
      *
+     * With PortFlag::STEERING_LANE, the port can send steering messages (see sendSteering()).<br/>
      * Please note this method can only be called before the initialize method call.
      */
-    void addOutputPort(const QString & name);
+    PortHandle addOutputPort(const QString & name, int flags = PortFlag::NONE);
+
+    /**
+     * @brief Gets a handle on an input port
+     * @param name The input port name
+     * @return A handle on the input port, which is invalid if there is no such input port
+     */
+    PortHandle inputPort(const QString & name) const;
+
+    /**
+     * @brief Gets a handle on an output port
+     * @param name The output port name
+     * @return A handle on the output port, which is invalid if there is no such output port
+     */
+    PortHandle outputPort(const QString & name) const;
 
     ///@}
 
@@ -215,7 +245,7 @@ public:
      * @return true if a valid message had been read, false otherwise.
      *
      * This method returns false if there is no message on the given input port.<br/>
-     * This method also returns false if an invalid message is available on the given input port, which occurs on lossy connections (to avoid message duplication, false messages may be sent).
+     * This method also returns false if the available message is invalid.
      */
     bool readMessage(const QString & iport, MessageReader & reader);
 
@@ -227,12 +257,122 @@ public:
      * @return true if a valid message had been read, false otherwise.
      *
      * This method returns false if there is no message on the given input port.<br/>
-     * This method also returns false if an invalid message is available on the given input port, which occurs on lossy connections (to avoid message duplication, false messages may be sent).
+     * This method also returns false if the available message is invalid.<br/>
+     * If the message is bigger than <i>size</i>, it is dropped and this method returns false.
+     * Use readMessage(const QString &, char *, unsigned int, unsigned int &) to know the message size instead.
      *
      * If this method returns false, the user specified memory location had not been written by this method.
      */
     bool readMessage(const QString & iport, char * data, unsigned int size);
 
+    /**
+     * @brief Tries to read a message from an input port and store it in a user specified memory location
+     * @param iport The input port name
+     * @param data The data pointer
+     * @param size The data maximum size, in bytes
+     * @param messageSize The real message size, in bytes. Set to 0 if no valid message had been read
+     * @return true if a valid message had been read, false otherwise.
+     *
+     * This method returns false if there is no message on the given input port, or if it is invalid (see readMessage(const QString &, MessageReader &)).<br/>
+     * If the message is bigger than <i>size</i>, this method returns false and sets <i>messageSize</i> to the required size.
+     * The message is kept on the port, so that the next read call on this port returns it.
+     *
+     * If this method returns false, the user specified memory location had not been written by this method.
+     */
+    bool readMessage(const QString & iport, char * data, unsigned int size, unsigned int & messageSize);
+
+    /**
+     * @brief Tries to read a message from an input port and store it in a MessageReader
+     * @param iport The input port handle
+     * @param reader The MessageReader
+     * @return true if a valid message had been read, false otherwise.
+     *
+     * Same as readMessage(const QString &, MessageReader &), without any port name lookup.
+     */
+    bool readMessage(const PortHandle & iport, MessageReader & reader);
+
+    /**
+     * @brief Tries to read a message from an input port and store it in a user specified memory location
+     * @param iport The input port handle
+     * @param data The data pointer
+     * @param size The data maximum size, in bytes
+     * @return true if a valid message had been read, false otherwise.
+     *
+     * Same as readMessage(const QString &, char *, unsigned int), without any port name lookup.
+     */
+    bool readMessage(const PortHandle & iport, char * data, unsigned int size);
+
+    /**
+     * @brief Tries to read a message from an input port and store it in a user specified memory location
+     * @param iport The input port handle
+     * @param data The data pointer
+     * @param size The data maximum size, in bytes
+     * @param messageSize The real message size, in bytes. Set to 0 if no valid message had been read
+     * @return true if a valid message had been read, false otherwise.
+     *
+     * Same as readMessage(const QString &, char *, unsigned int, unsigned int &), without any port name lookup.
+     */
+    bool readMessage(const PortHandle & iport, char * data, unsigned int size, unsigned int & messageSize);
+
+    /**
+     * @brief Reads all the messages waiting on an input port at once
+     * @param iport The input port name
+     * @param readers The readers in which the messages are stored. The vector is resized to the number of read messages,
+     *        it can be kept from a call to another so that its storage is reused
+     * @param maxCount The maximum number of messages to read. If set to -1, every available message is read
+     * @return The number of read messages
+     *
+     * This method is meant for consumers which fall behind : the control work done by wait() and readMessage() (dynamic orders,
+     * polling of every port) is only done once for all the messages, instead of once per message.<br/>
+     * Messages are stored in the order readMessage(const QString &, MessageReader &) would have returned them.<br/>
+     * Messages received through shared memory are copied, as a producer only has a few slots to hand to its co-located readers.
+     */
+    int readMessages(const QString & iport, QVector<MessageReader> & readers, int maxCount = -1);
+
+    /**
+     * @brief Reads all the messages waiting on an input port at once
+     * @param iport The input port handle
+     * @param readers The readers in which the messages are stored
+     * @param maxCount The maximum number of messages to read. If set to -1, every available message is read
+     * @return The number of read messages
+     *
+     * Same as readMessages(const QString &, QVector<MessageReader> &, int), without any port name lookup.
+     */
+    int readMessages(const PortHandle & iport, QVector<MessageReader> & readers, int maxCount = -1);
+
+    /**
+     * @brief Tries to read the next message sent by a given source on an input port
+     * @param iport The input port name
+     * @param sourceId The identifier of the source output port (see MessageReader::sourceId() and sourceId())
+     * @param reader The MessageReader
+     * @return true if a message of the source had been read, false otherwise
+     *
+     * This method is meant for input ports fed by many producers, such as the instances of a ParallelProcess.<br/>
+     * The messages of the other sources met meanwhile are kept, per source, without being copied.
+     * They are returned later by this method or, in arrival order, by readMessage(const QString &, MessageReader &).
+     */
+    bool readMessageFrom(const QString & iport, quint32 sourceId, MessageReader & reader);
+
+    /**
+     * @brief Tries to read the next message sent by a given source on an input port
+     * @param iport The input port handle
+     * @param sourceId The identifier of the source output port
+     * @param reader The MessageReader
+     * @return true if a message of the source had been read, false otherwise
+     *
+     * Same as readMessageFrom(const QString &, quint32, MessageReader &), without any port name lookup.
+     */
+    bool readMessageFrom(const PortHandle & iport, quint32 sourceId, MessageReader & reader);
+
+    /**
+     * @brief Gets the identifier of a source output port
+     * @param sourceName The source name, formatted like MessageReader::sourceName(), for example "Foo42:out"
+     * @return The source identifier, or 0 if no connection from this source is known
+     *
+     * Identifiers are unique within the application, they can be looked up once and then compared.
+     */
+    quint32 sourceId(const QString & sourceName);
+
     /**
      * @brief Allows to wait, without specifying any waiting condition.
      *
@@ -245,7 +385,7 @@ public:
      * @brief Allows to wait on a single input port
      * @param iport The input port on which the wait will occur
      * @param msToWait The total number of milliseconds to wait. If set to 0, the method will return immediately. If set to -1, the method will loop until the port has received a message
-     * @param msToSleep The number of milliseconds to sleep between two tries. If set to 0, there won't be any sleep. If set to -1, the sleep time will be set to 1 µs
+     * @param msToSleep The number of milliseconds to sleep between two tries. If set to 0, there won't be any sleep. If set to -1, the sleep time will be set to 1 µs. This parameter is only used in WaitMode::POLLING
      * @return true if a message had been received, false otherwise
      *
      * This method allows to enter the waiting state.<br/>
@@ -253,18 +393,111 @@ public:
      */
     bool wait(const QString & iport, int msToWait = -1, int msToSleep = 1);
 
+    /**
+     * @brief Allows to wait on a single input port
+     * @param iport The input port handle
+     * @param msToWait The total number of milliseconds to wait. If set to 0, the method will return immediately. If set to -1, the method will loop until the port has received a message
+     * @param msToSleep The number of milliseconds to sleep between two tries. If set to 0, there won't be any sleep. If set to -1, the sleep time will be set to 1 µs. This parameter is only used in WaitMode::POLLING
+     * @return true if a message had been received, false otherwise
+     *
+     * Same as wait(const QString &, int, int), without any port name lookup.
+     */
+    bool wait(const PortHandle & iport, int msToWait = -1, int msToSleep = 1);
+
     /**
      * @brief Allows to wait on one of many input ports sets
      * @param iports The set of sets of input ports on which the wait will occur
      * @param msToWait The total number of milliseconds to wait. If set to 0, the method will return immediately. If set to -1, the method will loop until the port has received a message
-     * @param msToSleep The number of milliseconds to sleep between two tries. If set to 0, there won't be any sleep. If set to -1, the sleep time will be set to 1 µs
+     * @param msToSleep The number of milliseconds to sleep between two tries. If set to 0, there won't be any sleep. If set to -1, the sleep time will be set to 1 µs. This parameter is only used in WaitMode::POLLING
      * @return true if at least one of the input ports sets waiting condition is fulfilled, which means a message is available on every input port within it
      *
      * This method allows to enter the waiting state.<br/>
-     * Every module needs to be in the waiting state occasionally, to handle message sending on lossy connections and to allow dynamic alterations of the application network.
+     * Every module needs to be in the waiting state occasionally, to handle message sending on lossy connections and to allow dynamic alterations of the application network.<br/>
+     * Use waitAny(const QList<QStringList> &, int, int) to know which set is fulfilled.
      */
     bool wait(const QList<QStringList> & iports, int msToWait = -1, int msToSleep = 1);
 
+    /**
+     * @brief Allows to wait on one of many input ports sets, and tells which one is fulfilled
+     * @param iports The set of sets of input ports on which the wait will occur
+     * @param msToWait The total number of milliseconds to wait. If set to 0, the method will return immediately. If set to -1, the method will loop until a set is fulfilled
+     * @param msToSleep The number of milliseconds to sleep between two tries. If set to 0, there won't be any sleep. If set to -1, the sleep time will be set to 1 µs. This parameter is only used in WaitMode::POLLING
+     * @return The index of the first fulfilled set within iports (a message is available on every input port within it), or -1 if none is
+     *
+     * Same as wait(const QList<QStringList> &, int, int). The sets are turned into bitmasks of input ports once, so that every try only costs
+     * a few bit operations per set.
+     */
+    int waitAny(const QList<QStringList> & iports, int msToWait = -1, int msToSleep = 1);
+
+    /**
+     * @brief Allows to wait on one of many input ports sets, and tells which one is fulfilled
+     * @param iports The set of sets of input port handles on which the wait will occur
+     * @param msToWait The total number of milliseconds to wait, see waitAny(const QList<QStringList> &, int, int)
+     * @param msToSleep The number of milliseconds to sleep between two tries, see waitAny(const QList<QStringList> &, int, int)
+     * @return The index of the first fulfilled set within iports, or -1 if none is
+     *
+     * Same as waitAny(const QList<QStringList> &, int, int), without any port name lookup.
+     */
+    int waitAny(const QList<QList<PortHandle> > & iports, int msToWait = -1, int msToSleep = 1);
+
+    /**
+     * @brief Waits for and reads the messages of the same iteration on several input ports
+     * @param iports The input ports to join
+     * @param readers Filled with one message per input port (readers[i] was received on iports[i]) if the method returns true
+     * @param msToWait The total number of milliseconds to wait. If set to 0, the method will return immediately. If set to -1, the method will loop until an iteration is complete
+     * @param policy What is done with the iterations which are not complete on every port
+     * @param msStragglerTimeout With JoinPolicy::TIMEOUT, the number of milliseconds an incomplete iteration is waited for since its first message arrived
+     * @param key The iteration number messages are matched on
+     * @param msToSleep The number of milliseconds to sleep between two tries, see wait(const QString &, int, int)
+     * @return true if a complete iteration had been read, false otherwise
+     *
+     * This method allows to enter the waiting state, like wait().<br/>
+     * The messages received on the joined ports are kept in a join buffer per port, by iteration number, until a message of the same
+     * iteration is there on every port. Once an iteration is released, the buffered messages of the older iterations are dropped.<br/>
+     * Each joined port is expected to receive the messages of a single source. The messages of a joined port must only be read by this method.
+     */
+    bool join(const QStringList & iports, QVector<MessageReader> & readers, int msToWait = -1,
+              JoinPolicy::JoinPolicy policy = JoinPolicy::WAIT, int msStragglerTimeout = 0,
+              JoinKey::JoinKey key = JoinKey::PORT_ITERATION, int msToSleep = 1);
+
+    /**
+     * @brief Sets how the wait methods wait for messages
+     * @param mode The wait mode
+     * @param msDynamicOrderPeriod In WaitMode::BLOCKING, the maximum number of milliseconds spent blocked before dynamic orders are checked again
+     *
+     * In WaitMode::BLOCKING (the default), the wait methods block on the input sockets and on the lossy output sockets until a message
+     * or a lossy credit arrives, which avoids both busy loops and sleep latency.<br/>
+     * Dynamic orders come from the master through MPI and cannot be waited on with the sockets, which is why the blocking is split
+     * into slices of msDynamicOrderPeriod milliseconds.<br/>
+     * In WaitMode::POLLING, the sockets are checked without blocking and the module sleeps msToSleep between two tries.
+     */
+    void setWaitMode(WaitMode::WaitMode mode, int msDynamicOrderPeriod = 10);
+
+    /**
+     * @brief Gets how the wait methods wait for messages
+     * @return The current wait mode
+     */
+    WaitMode::WaitMode waitMode() const { return _waitMode; }
+
+    /**
+     * @brief Starts a background thread which makes the module progress while user code does not call it
+     * @param msPeriod The number of milliseconds the thread sleeps between two checks
+     * @return true if the thread had been started, false otherwise
+     *
+     * Lossy credits, batch deadlines and dynamic orders are otherwise only handled when user code calls a Module method,
+     * so a long computation delays lossy receivers and blocks the master while it applies dynamic orders.
+     * The thread handles them every msPeriod milliseconds instead.<br/>
+     * Module methods and the thread are serialized by a mutex, which is only held during Module calls.
+     * The Module must therefore not be used by several user threads at once.<br/>
+     * The thread requires MPI to support MPI_THREAD_SERIALIZED. It is stopped by finalize().
+     */
+    bool startProgressThread(int msPeriod = 10);
+
+    /**
+     * @brief Stops the thread started by startProgressThread(), if any
+     */
+    void stopProgressThread();
+
     /**
      * @brief This method allows to know whether a message can be read on the given input port or not
      * @param iport The input port on which the message existence is checked
@@ -274,6 +507,15 @@ public:
      */
     bool messageAvailable(const QString & iport);
 
+    /**
+     * @brief This method allows to know whether a message can be read on the given input port or not
+     * @param iport The input port handle
+     * @return true if a message is available, false otherwise
+     *
+     * Same as messageAvailable(const QString &), without any port name lookup.
+     */
+    bool messageAvailable(const PortHandle & iport);
+
     /**
      * @brief This method allows to know whether a message can be read on every given input ports or not
      * @param iports The input ports on which the message existence is checked
@@ -283,6 +525,26 @@ public:
      */
     bool messageAvailable(const QStringList & iports);
 
+    /**
+     * @brief This method allows to know whether a message of a given source can be read on an input port or not
+     * @param iport The input port on which the message existence is checked
+     * @param sourceId The identifier of the source output port (see sourceId())
+     * @return true if a message of the source is available, false otherwise
+     *
+     * The messages already received on the port are put aside by source to answer, see readMessageFrom().
+     */
+    bool messageAvailableFrom(const QString & iport, quint32 sourceId);
+
+    /**
+     * @brief This method allows to know whether a message of a given source can be read on an input port or not
+     * @param iport The input port handle
+     * @param sourceId The identifier of the source output port
+     * @return true if a message of the source is available, false otherwise
+     *
+     * Same as messageAvailableFrom(const QString &, quint32), without any port name lookup.
+     */
+    bool messageAvailableFrom(const PortHandle & iport, quint32 sourceId);
+
     /**
      * @brief Thiodules method allows to know whether an input port is connected or not
      * @param iport The input port
@@ -301,6 +563,8 @@ public:
      * @brief This method allows to send a message on a given output port
      * @param port The output port on which the message is sent
      * @param writer The MessageWriter, which allowed the user to write data in the message
+     *
+     * How the writer buffer is handed to the network depends on the send mode, see setSendMode().
      */
     void send(const QString & port, const MessageWriter & writer);
 
@@ -312,6 +576,355 @@ public:
      */
     void send(const QString &port, const char * data, unsigned int size);
 
+    /**
+     * @brief This method allows to send a message on a given output port
+     * @param port The output port handle
+     * @param writer The MessageWriter, which allowed the user to write data in the message
+     *
+     * Same as send(const QString &, const MessageWriter &), without any port name lookup.
+     */
+    void send(const PortHandle & port, const MessageWriter & writer);
+
+    /**
+     * @brief This method allows to send raw data on a given output port
+     * @param port The output port handle
+     * @param data The pointer to the data
+     * @param size The number of bytes to send
+     *
+     * Same as send(const QString &, const char *, unsigned int), without any port name lookup.
+     */
+    void send(const PortHandle & port, const char * data, unsigned int size);
+
+    /**
+     * @brief Sends one message on several output ports at once
+     * @param ports The output ports on which the message is sent
+     * @param writer The MessageWriter, which allowed the user to write data in the message
+     *
+     * Every port sends its own stamp, with its own iteration number, but the payload is shared :
+     * the writer buffer is handed once to ZeroMQ and each port only holds a reference on it.
+     * Nothing is sent if a port name is invalid.
+     */
+    void send(const QStringList & ports, const MessageWriter & writer);
+
+    /**
+     * @brief Sends the same raw data on several output ports at once
+     * @param ports The output ports on which the message is sent
+     * @param data The pointer to the data, which is copied once
+     * @param size The number of bytes to send
+     *
+     * See send(const QStringList &, const MessageWriter &).
+     */
+    void send(const QStringList & ports, const char * data, unsigned int size);
+
+    /**
+     * @brief Sends one message on several output ports at once
+     * @param ports The output port handles
+     * @param writer The MessageWriter, which allowed the user to write data in the message
+     *
+     * Same as send(const QStringList &, const MessageWriter &), without any port name lookup.
+     */
+    void send(const QList<PortHandle> & ports, const MessageWriter & writer);
+
+    /**
+     * @brief Sends the same raw data on several output ports at once
+     * @param ports The output port handles
+     * @param data The pointer to the data, which is copied once
+     * @param size The number of bytes to send
+     *
+     * Same as send(const QStringList &, const char *, unsigned int), without any port name lookup.
+     */
+    void send(const QList<PortHandle> & ports, const char * data, unsigned int size);
+
+    /**
+     * @brief Sends a received message on a given output port, without copying it
+     * @param port The output port on which the message is sent
+     * @param reader The MessageReader filled by readMessage(const QString &, MessageReader &)
+     *
+     * The received ZeroMQ message is handed as is to the output socket, only a new stamp is built (the message gets the
+     * iteration numbers of this process and of the output port). The read cursor of the reader is ignored.<br/>
+     * The content is only copied if the output port batches its messages (see setBatching()).
+     */
+    void send(const QString & port, const MessageReader & reader);
+
+    /**
+     * @brief Sends a received message on a given output port, without copying it
+     * @param port The output port handle
+     * @param reader The MessageReader filled by readMessage(const QString &, MessageReader &)
+     *
+     * Same as send(const QString &, const MessageReader &), without any port name lookup.
+     */
+    void send(const PortHandle & port, const MessageReader & reader);
+
+    /**
+     * @brief Reads a message on an input port and sends it on an output port, without copying it
+     * @param iport The input port on which the message is read
+     * @param oport The output port on which the message is sent
+     * @return true if a message was forwarded, false if there was no message to read (or if a port is invalid)
+     *
+     * This is what relay modules do : it is equivalent to readMessage(const QString &, MessageReader &) followed by
+     * send(const QString &, const MessageReader &), in a single critical section.
+     */
+    bool forward(const QString & iport, const QString & oport);
+
+    /**
+     * @brief Reads a message on an input port and sends it on an output port, without copying it
+     * @param iport The input port handle
+     * @param oport The output port handle
+     * @return true if a message was forwarded, false otherwise
+     *
+     * Same as forward(const QString &, const QString &), without any port name lookup.
+     */
+    bool forward(const PortHandle & iport, const PortHandle & oport);
+
+    /**
+     * @brief Sends a message on a given output port, from any thread
+     * @param port The output port on which the message is sent
+     * @param writer The MessageWriter, which allowed the user to write data in the message
+     *
+     * Unlike send(), this method can be called by many threads at once (for example within an OpenMP parallel region).
+     * The message is put in a lock-free queue and actually sent by the thread which uses the Module, at its next send(),
+     * flush() or wait() call, or by the progress thread (see startProgressThread()).<br/>
+     * Messages get their iteration numbers when they leave the queue, in the order they had been posted.
+     * The message shares the writer buffer (implicit sharing), so posting does not copy it. The writer can be reused at once,
+     * but writing into it again then copies its whole buffer first, on the calling thread.<br/>
+     * Messages posted once the module is finalized are dropped.
+     */
+    void postMessage(const QString & port, const MessageWriter & writer);
+
+    /**
+     * @brief Sends raw data on a given output port, from any thread
+     * @param port The output port on which the message is sent
+     * @param data The pointer to the data, which is copied
+     * @param size The number of bytes to send
+     *
+     * See postMessage(const QString &, const MessageWriter &).
+     */
+    void postMessage(const QString & port, const char * data, unsigned int size);
+
+    /**
+     * @brief Sends a message on a given output port, from any thread
+     * @param port The output port handle
+     * @param writer The MessageWriter, which allowed the user to write data in the message
+     *
+     * Same as postMessage(const QString &, const MessageWriter &), without any port name lookup.
+     */
+    void postMessage(const PortHandle & port, const MessageWriter & writer);
+
+    /**
+     * @brief Sends raw data on a given output port, from any thread
+     * @param port The output port handle
+     * @param data The pointer to the data, which is copied
+     * @param size The number of bytes to send
+     *
+     * Same as postMessage(const QString &, const char *, unsigned int), without any port name lookup.
+     */
+    void postMessage(const PortHandle & port, const char * data, unsigned int size);
+
+    /**
+     * @brief Sends a small urgent message, such as a steering parameter, on the steering lane of an output port
+     * @param port The output port on which the message is sent, which must have been added with PortFlag::STEERING_LANE
+     * @param writer The MessageWriter, which allowed the user to write data in the message
+     *
+     * The steering lane is a separate lossless socket, wired up by the master next to each connection of the port
+     * whose input port has a lane too. Steering messages therefore never queue behind the bulk data sent with send().
+     * wait() and readMessage() serve them before any other message of the input port.<br/>
+     * They bypass batching, rate limiting and bounded queues, and have their own port iteration numbers.
+     */
+    void sendSteering(const QString & port, const MessageWriter & writer);
+
+    /**
+     * @brief Sends small urgent raw data on the steering lane of an output port
+     * @param port The output port on which the message is sent, which must have been added with PortFlag::STEERING_LANE
+     * @param data The pointer to the data
+     * @param size The number of bytes to send
+     *
+     * See sendSteering(const QString &, const MessageWriter &).
+     */
+    void sendSteering(const QString & port, const char * data, unsigned int size);
+
+    /**
+     * @brief Sends a small urgent message on the steering lane of an output port
+     * @param port The output port handle
+     * @param writer The MessageWriter, which allowed the user to write data in the message
+     *
+     * Same as sendSteering(const QString &, const MessageWriter &), without any port name lookup.
+     */
+    void sendSteering(const PortHandle & port, const MessageWriter & writer);
+
+    /**
+     * @brief Sends small urgent raw data on the steering lane of an output port
+     * @param port The output port handle
+     * @param data The pointer to the data
+     * @param size The number of bytes to send
+     *
+     * Same as sendSteering(const QString &, const char *, unsigned int), without any port name lookup.
+     */
+    void sendSteering(const PortHandle & port, const char * data, unsigned int size);
+
+    /**
+     * @brief Sets how send(const QString &, const MessageWriter &) hands the MessageWriter buffer to the network
+     * @param mode The send mode
+     *
+     * In SendMode::COPY (the default), ZeroMQ copies the buffer into its own message.<br/>
+     * In SendMode::ZERO_COPY, ZeroMQ sends the buffer itself. The message holds a reference on the buffer, which is released
+     * once the message has been sent. Writing again in the MessageWriter afterwards is safe: the writer then detaches from
+     * the sent buffer (copy-on-write), so it is cheaper to use a new MessageWriter for each message.<br/>
+     * <br/>
+     * In both modes, the last value kept for lossy connections shares the sent message instead of copying it.<br/>
+     * Raw data sent with send(const QString &, const char *, unsigned int) is always copied, since its memory belongs to the user.
+     */
+    void setSendMode(SendMode::SendMode mode) { _sendMode = mode; }
+
+    /**
+     * @brief Gets how send(const QString &, const MessageWriter &) hands the MessageWriter buffer to the network
+     * @return The current send mode
+     */
+    SendMode::SendMode sendMode() const { return _sendMode; }
+
+    /**
+     * @brief Enables or disables the batching of the messages sent on an output port
+     * @param port The output port
+     * @param maxBytes The batch is sent once it reaches this size, in bytes. 0 disables batching (the default)
+     * @param msMaxDelay The batch is sent once its first message has waited this long, in milliseconds
+     * @return true if the batching had been set, false otherwise
+     *
+     * Batching packs many small messages into one network message, which saves the per-message costs.
+     * Receivers read the messages one by one as usual, with their original iteration numbers.<br/>
+     * The delay is checked whenever the module sends, waits or reads a message. A batch can also be sent at once with flush().<br/>
+     * Disabling batching flushes the current batch.
+     */
+    bool setBatching(const QString & port, int maxBytes, int msMaxDelay = 10);
+
+    /**
+     * @brief Enables or disables the batching of the messages sent on an output port
+     * @param port The output port handle
+     * @param maxBytes The batch is sent once it reaches this size, in bytes. 0 disables batching (the default)
+     * @param msMaxDelay The batch is sent once its first message has waited this long, in milliseconds
+     * @return true if the batching had been set, false otherwise
+     *
+     * Same as setBatching(const QString &, int, int), without any port name lookup.
+     */
+    bool setBatching(const PortHandle & port, int maxBytes, int msMaxDelay = 10);
+
+    /**
+     * @brief Sends the current batch of an output port right now
+     * @param port The output port
+     *
+     * Nothing is sent if the batch is empty or if batching is disabled on the port.
+     */
+    void flush(const QString & port);
+
+    /**
+     * @brief Sends the current batch of an output port right now
+     * @param port The output port handle
+     *
+     * Same as flush(const QString &), without any port name lookup.
+     */
+    void flush(const PortHandle & port);
+
+    /**
+     * @brief Limits the rate of the messages sent on an output port
+     * @param oport The output port
+     * @param messagesPerSecond The maximum number of messages sent per second. 0 removes this limit
+     * @param bytesPerSecond The maximum number of bytes sent per second. 0 removes this limit
+     * @param policy What to do with a message sent while the limit is reached
+     * @return true if the limit had been set, false otherwise
+     *
+     * This protects shared links from fast producers without sleeping in the module loop.
+     * The limit follows a token bucket, which allows bursts of a tenth of a second of traffic.
+     * A batch (see setBatching) counts as one message.<br/>
+     * Once the limit is reached, a sent message is handled depending on the policy :
+     * <ul>
+     *     <li> QueuePolicy::BLOCK : send() waits until the message can be sent </li>
+     *     <li> QueuePolicy::DROP_OLDEST : the message is kept, replacing the one which was waiting, and is sent once possible.
+     *          This is checked whenever the module sends, waits or reads a message </li>
+     *     <li> QueuePolicy::DROP_NEWEST : the message is dropped </li>
+     * </ul>
+     * Dropped messages are counted by droppedMessageCount().<br/>
+     * The application can also set the limit with Application::setRateLimit, which is applied on initialize().
+     * Setting both rates to 0 removes the limit and sends the waiting message, if any.
+     */
+    bool setRateLimit(const QString & oport, double messagesPerSecond, double bytesPerSecond,
+                      QueuePolicy::QueuePolicy policy = QueuePolicy::BLOCK);
+
+    /**
+     * @brief Limits the rate of the messages sent on an output port
+     * @param oport The output port handle
+     * @param messagesPerSecond The maximum number of messages sent per second. 0 removes this limit
+     * @param bytesPerSecond The maximum number of bytes sent per second. 0 removes this limit
+     * @param policy What to do with a message sent while the limit is reached
+     * @return true if the limit had been set, false otherwise
+     *
+     * Same as setRateLimit(const QString &, double, double, QueuePolicy::QueuePolicy), without any port name lookup.
+     */
+    bool setRateLimit(const PortHandle & oport, double messagesPerSecond, double bytesPerSecond,
+                      QueuePolicy::QueuePolicy policy = QueuePolicy::BLOCK);
+
+    /**
+     * @brief Makes an input port keep only the newest message of each source
+     * @param iport The input port
+     * @param latestOnly true to keep only the newest messages, false to receive every message (the default)
+     * @return true if the mode had been set, false otherwise
+     *
+     * This is meant for consumers which only care about fresh data, such as visualizations.
+     * Whenever the port is read or waited on, every message which arrived on its lossless connections is received
+     * and only the newest one of each source is kept. The older ones are released without being copied, so
+     * readMessage() returns the freshest data however far behind the consumer is.<br/>
+     * Lossy connections already behave this way.
+     */
+    bool setLatestOnly(const QString & iport, bool latestOnly = true);
+
+    /**
+     * @brief Makes an input port keep only the newest message of each source
+     * @param iport The input port handle
+     * @param latestOnly true to keep only the newest messages, false to receive every message (the default)
+     * @return true if the mode had been set, false otherwise
+     *
+     * Same as setLatestOnly(const QString &, bool), without any port name lookup.
+     */
+    bool setLatestOnly(const PortHandle & iport, bool latestOnly = true);
+
+    /**
+     * @brief Gets how many messages received on an input port had expired before being read
+     * @param iport The input port
+     * @return The number of expired messages since the module started, over every connection of the port
+     *
+     * Only the connections with a time to live make messages expire (see Application::connect).
+     * Expired messages are released as they are met by readMessage(), without being copied to the user.
+     * A wait() may therefore return true while readMessage() only finds expired messages.
+     */
+    quint64 expiredMessageCount(const QString & iport);
+
+    /**
+     * @brief Gets how many messages received on an input port had expired before being read
+     * @param iport The input port handle
+     * @return The number of expired messages since the module started, over every connection of the port
+     *
+     * Same as expiredMessageCount(const QString &), without any port name lookup.
+     */
+    quint64 expiredMessageCount(const PortHandle & iport);
+
+    /**
+     * @brief Gets how many messages sent on an output port had been dropped
+     * @param oport The output port
+     * @return The number of dropped messages since the module started, over every connection of the port
+     *
+     * Messages are only dropped by the bounded connections which use the QueuePolicy::DROP_OLDEST or the
+     * QueuePolicy::DROP_NEWEST policy once their queue is full, by the QueuePolicy::ADAPTIVE ones while they are lossy
+     * (see Application::connect), by the rate limit of the port (see setRateLimit), and by the lossy and bounded
+     * connections with a time to live, which do not push stale messages.
+     */
+    quint64 droppedMessageCount(const QString & oport);
+
+    /**
+     * @brief Gets how many messages sent on an output port had been dropped
+     * @param oport The output port handle
+     * @return The number of dropped messages since the module started, over every connection of the port
+     *
+     * Same as droppedMessageCount(const QString &), without any port name lookup.
+     */
+    quint64 droppedMessageCount(const PortHandle & oport);
+
     /**
      * @brief Gets every available source of a given port. Sources are formatted as 12:3, where 1 is the module name, 2 the module instance number and 3 the port name
      * @param iport The input port
@@ -362,11 +975,20 @@ public:
      * @param destinationInstance The instance number of the destination process
      * @param destinationPort The input port name of the destination process
      * @param lossyConnection If set to true, the connection will be lossy. Otherwise, it will be lossless
+     * @param queueBound The maximum number of messages queued for the destination on a lossless connection. 0 means unbounded
+     * @param queuePolicy What is done with a new message once the queue is full. Only used if queueBound is positive
+     * @param msTimeToLive Messages older than this, in milliseconds, are dropped instead of being read. 0 means they never expire
+     * @param decimation Only one message out of decimation is sent to the destination. 1 means every message
+     * @param maxFrequency The maximum number of messages sent to the destination per second. 0 means unlimited
      * @return true if the connection has been done, false otherwise
+     *
+     * See Application::connect for bounded connections, time to live and sampling.
      */
     bool addConnection(const QString & sourceName, int sourceInstance, const QString & sourcePort,
                        const QString & destinationName, int destinationInstance, const QString & destinationPort,
-                       bool lossyConnection = false);
+                       bool lossyConnection = false, int queueBound = 0,
+                       QueuePolicy::QueuePolicy queuePolicy = QueuePolicy::BLOCK, int msTimeToLive = 0,
+                       int decimation = 1, double maxFrequency = 0);
 
     /**
      * @brief This method allows to dynamically remove a connection in the network
@@ -406,6 +1028,8 @@ public:
     bool killProcess(const QString & moduleName, int instance);
 
 private:
+    friend class ProgressThread;
+
     QString xmlDescription() const;
     void sendDescription();
 
@@ -431,10 +1055,82 @@ private:
     void handleDynamicInputDisconnect(const DynamicOrder & o);
     void handleDynamicDestroy();
 
-    bool sendAndReceiveRequest(const DynamicRequest & r);
+    int orderedPortIndex(const QMap<QString, int> & portIndexes, const QString & portName); //! -1 (with an error) if there is no such port
+    void answerSync(); //! Connection handshake, on the side which accepts the connection
+    void requestSync(const QString & remoteIP, quint16 syncPort); //! Connection handshake, on the side which connects
 
-    void handleOnRequestSends();
-    void updateMessageAvailability();
+    bool sendAndReceiveRequest(const DynamicRequest & r);
+    int receiveRequestResult();
+
+    void progress(int msLockTimeout); //! Called periodically by the progress thread, does nothing if the lock is not acquired in time
+    QMutex * progressLock() { return _progressThread ? &_progressMutex : 0; } //! 0 if there is no progress thread (QMutexLocker then does nothing)
+
+    void handleLossyPushes();
+    bool pushLastMessage(OutputPort & op, LossyRemote & remote);
+    void queueForBoundedRemotes(OutputPort & op, const Stamp & stamp, zmq::message_t & msg);
+    void pushQueuedMessages(OutputPort & op, BoundedRemote & remote);
+    void waitForBoundedRemote(OutputPort & op, quint32 remoteId);
+    void publish(OutputPort & op, zmq::message_t & msg);
+    void publish(OutputPort & op, const Stamp & stamp, zmq::message_t & msg);
+    void transmit(OutputPort & op, const Stamp & stamp, zmq::message_t & msg);
+    bool checkOutputPortHandles(const QList<PortHandle> & ports, const char * method);
+    bool resolveOutputPorts(const QStringList & names, const char * method, QList<PortHandle> & ports);
+    void sendShared(const QList<PortHandle> & ports, zmq::message_t & payload);
+    void sendReceived(OutputPort & op, const QSharedPointer<zmq::message_t> & message);
+    void publishSteering(OutputPort & op, const char * data, unsigned int size);
+    void connectSteeringLane(InputPort & port, const QString & remoteName, const QString & remoteIP,
+                             quint16 steeringPort, const QString & steeringIpc);
+    void disconnectSteeringLane(InputPort & port, const QString & remoteName);
+
+    bool pace(OutputPort & op, const Stamp & stamp, zmq::message_t & msg);
+    void waitForTokens(OutputPort & op, int size);
+    void flushPacedMessage(OutputPort & op, bool force);
+    void flushPacedMessages();
+    int pacingTimeout() const;
+    void applyRateLimitArguments();
+
+    void appendToBatch(OutputPort & op, const char * data, int size);
+    void flushBatch(OutputPort & op);
+    void flushExpiredBatches();
+    void postMessage(const PortHandle & port, SendQueue::Message * message);
+    void drainSendQueue(OutputPort & op);
+    void drainSendQueues();
+    int batchTimeout() const;
+    bool unpackBatch(InputPort & port, ReceivedMessage & message);
+
+    void addLossyChannel(InputPort & port, const QString & remoteName, const QByteArray & endpoint);
+    void removeLossyChannel(InputPort & port, const QString & remoteName);
+
+    void publishSharedMemory(OutputPort & op, const Stamp & stamp, zmq::message_t & msg);
+    bool writeSharedMemory(OutputPort & op, zmq::message_t & msg);
+    void handleSharedMemorySubscriptions(OutputPort & op);
+    void addSharedMemoryReader(OutputPort & op, const QString & remoteName, quint32 remoteId, bool lossless);
+    void removeSharedMemoryReader(OutputPort & op, const QString & remoteName);
+    void subscribeToSharedMemory(InputPort & port);
+    bool mapSharedMemoryMessage(InputPort & port, ReceivedMessage & message);
+    bool resolveInputPort(const QString & name, const char * method, PortHandle & port);
+    bool resolveOutputPort(const QString & name, const char * method, PortHandle & port);
+    bool isInputPortHandle(const PortHandle & port) const { return port._isInput && port._index >= 0 && port._index < _inputPorts.size(); }
+    bool isOutputPortHandle(const PortHandle & port) const { return !port._isInput && port._index >= 0 && port._index < _outputPorts.size(); }
+
+    bool receiveMessage(InputPort & port, ReceivedMessage & message);
+    bool receiveUnsortedMessage(InputPort & port, ReceivedMessage & message);
+    bool receiveMessageFrom(InputPort & port, quint32 sourceId, ReceivedMessage & message);
+    void putAside(InputPort & port, const ReceivedMessage & message);
+    void releaseRingSlot(ReceivedMessage & message);
+    bool receiveNextMessage(InputPort & port, ReceivedMessage & message);
+    bool decodeMessage(InputPort & port, zmq::message_t & stampMsg, ReceivedMessage & message);
+    void conflate(InputPort & port);
+    void updateMessageAvailability(long msTimeout = 0);
+    void serviceOnce(long msTimeout = 0); //! The work of every waiting try : lossy pushes, posted messages, batches, paced messages, then polling
+    bool nextTry(const QTime & time, int msToWait, int usToSleep, QMutexLocker & locker, long & msTimeout, int msMaxTimeout = -1); //! false if the wait is over
+    void expectMessages(InputPort & port);
+    bool pollInputPort(InputPort & port);
+    int waitForPortSets(const QVector<QVector<quint64> > & sets, int msToWait, int msToSleep);
+    bool releaseJoinedMessages(const QVector<int> & ports, QVector<MessageReader> & readers, JoinPolicy::JoinPolicy policy,
+                               int msStragglerTimeout, JoinKey::JoinKey key);
+    int stragglerTimeout(const QVector<int> & ports, int msStragglerTimeout) const;
+    int pollTimeout(const QTime & time, int msToWait) const;
 
     // These methods are useful to display information for debugging purpose
     QString currentConnectionsToString();
@@ -443,19 +1139,36 @@ private:
     QString _name;
     QString _ip;
     int _instanceNumber;
+    int _processId;
     bool _launchWithoutEnvironment;
     int _iterationNumber;
-    ModuleState::ModuleState _state;
+    std::atomic<ModuleState::ModuleState> _state; // Atomic, as postMessage() reads it from any thread
 
     zmq::context_t _context;
     zmq::socket_t _syncRep;
     quint16 _syncRepPort;
 
-    QMap<QString, InputPort> _inputPorts;
-    QMap<QString, OutputPort> _outputPorts;
+    // Ports are stored in flat arrays, indexed by PortHandle
+    QVector<InputPort> _inputPorts;
+    QVector<OutputPort> _outputPorts;
+    QMap<QString, int> _inputPortIndexes;
+    QMap<QString, int> _outputPortIndexes;
+
+    QMap<quint32, QString> _sourceNames; // Remote output port names by id. Never shrinks, so that messages still being read can be resolved
 
     QVector<zmq_pollitem_t> _pollItems;
 
+    WaitMode::WaitMode _waitMode;
+    int _msDynamicOrderPeriod;
+
+    SendMode::SendMode _sendMode;
+
+    ProgressThread * _progressThread;
+    QMutex _progressMutex; // Recursive, held by the progress thread and by the Module methods while it runs
+
+    int _sendWaitDepth; // Non zero while a send waits for its destinations, a destroy order is then only applied afterwards
+    bool _finalizeDeferred; // true => a destroy order was received during a send, finalize() is still to be called
+
     ArgumentReader _arguments;
 
     MPI_Comm _parent;
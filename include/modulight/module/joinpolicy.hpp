@@ -0,0 +1,41 @@
+#ifndef JOINPOLICY_HPP
+#define JOINPOLICY_HPP
+
+namespace modulight
+{
+    namespace JoinPolicy
+    {
+        /**
+         * @brief Represents what Module::join does with the iterations which are not complete (stragglers)
+         */
+        enum JoinPolicy
+        {
+            WAIT, //!< Iterations are released in order, the oldest one is waited for as long as it takes. Meant for lossless connections
+            NEWEST, //!< The newest complete iteration is released, the older ones are dropped. Each port buffers at most MAX_BUFFERED_ITERATIONS iterations
+            TIMEOUT //!< Iterations are released in order, but an incomplete one is dropped once it waited for more than the straggler timeout
+        };
+
+        /**
+         * @brief With JoinPolicy::NEWEST, the maximum number of iterations buffered by each joined port
+         *
+         * The oldest iterations are dropped beyond it, so that buffers stay bounded when iterations never line up
+         * (lossy or sampled sources, port iteration numbers of producers started at different times).
+         * The iterations older than the oldest one buffered by another port are dropped too, as they can not be complete anymore.
+         */
+        const int MAX_BUFFERED_ITERATIONS = 64;
+    }
+
+    namespace JoinKey
+    {
+        /**
+         * @brief Represents which iteration number Module::join matches messages on
+         */
+        enum JoinKey
+        {
+            PORT_ITERATION, //!< The iteration number of the source output port (MessageReader::sourcePortIterationNumber())
+            PROCESS_ITERATION //!< The iteration number of the source process (MessageReader::sourceProcessIterationNumber())
+        };
+    }
+}
+
+#endif // JOINPOLICY_HPP
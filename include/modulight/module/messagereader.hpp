@@ -5,10 +5,13 @@
 #include <vector>
 #include <stdexcept>
 
+#include <QMap>
 #include <QSharedPointer>
 #include <QString>
 #include <QVector>
 
+#include <zmq.hpp>
+
 #include <modulight/common/modulightexception.hpp>
 
 namespace modulight
@@ -25,7 +28,10 @@ class Module;
  * To avoid performance issues, no endianness conversion is done on data.<br/>
  * <br/>
  * All read functions extract a value from the data and then moves the read cursor.<br/>
- * This cursor might be obtained via cursorPosition() and moved with setCursorPosition(int)
+ * This cursor might be obtained via cursorPosition() and moved with setCursorPosition(int)<br/>
+ * <br/>
+ * The MessageReader keeps the received ZeroMQ message alive instead of copying it, so data() points directly into it.<br/>
+ * Copies of a MessageReader share the same message.
  */
 class MessageReader
 {
@@ -43,7 +49,7 @@ public:
 
     /**
     * @brief Gets the data pointer
-    * @return The data pointer
+    * @return The data pointer, which remains valid until the MessageReader is reloaded or destroyed
     */
    const char* data() const;
 
@@ -156,8 +162,18 @@ public:
     /**
      * @brief Gets the source of the received message
      * @return The message source, as a QString formatted "Foo42:out", which means the output port <i>out</i> of the 42th instance of the module Foo
+     *
+     * Messages only carry the numeric id of their source (see sourceId()), which is resolved to a name by this method.
+     */
+    QString sourceName() const;
+
+    /**
+     * @brief Gets the numeric identifier of the source of the received message
+     * @return The identifier of the output port which emitted the message, unique within the application
+     *
+     * Comparing identifiers is cheaper than comparing names.
      */
-    QString sourceName() const { return _source; }
+    quint32 sourceId() const { return _sourceId; }
 
     /**
      * @brief Gets the iteration number of the process which emitted the message
@@ -174,16 +190,20 @@ public:
     ///@}
 
 private:
-    void load(char * buf, int bufSize, const QString & localPortName, const QString & sourceName, int sourceProcessIterationNumber, int sourcePortIterationNumber);
+    void load(const QSharedPointer<zmq::message_t> & message, const QString & localPortName, quint32 sourceId,
+              const QMap<quint32, QString> * sourceNames, int sourceProcessIterationNumber, int sourcePortIterationNumber);
     void clear();
 
 private:
-    QVector<char> _data;
+    QSharedPointer<zmq::message_t> _message;
+    const char * _data;
+    int _size;
     bool _loaded;
     int _readCursor;
 
     QString _portName;
-    QString _source;
+    quint32 _sourceId;
+    const QMap<quint32, QString> * _sourceNames; // Owned by the Module
     int _moduleIteration;
     int _portIteration;
 };
@@ -193,19 +213,19 @@ private:
 template<typename T>
 std::vector<T> modulight::MessageReader::readStdVector()
 {
-    if (_readCursor + (int)sizeof(unsigned int) > _data.size())
+    if (_readCursor + (int)sizeof(unsigned int) > _size)
         throw Exception("Bad Message::readVector : out of bounds");
 
     unsigned int vectorSize;
 
-    memcpy(&vectorSize, &_data[_readCursor], sizeof(unsigned int));
+    memcpy(&vectorSize, _data + _readCursor, sizeof(unsigned int));
     _readCursor += sizeof(unsigned int);
 
-    if (_readCursor + (int)(vectorSize*sizeof(T)) > _data.size())
+    if (_readCursor + (int)(vectorSize*sizeof(T)) > _size)
         throw Exception("Bad Message::readVector : critical internal error in the written string");
 
     std::vector<T> ret (vectorSize);
-    memcpy(ret.data(), &_data[_readCursor], vectorSize * sizeof(T));
+    memcpy(ret.data(), _data + _readCursor, vectorSize * sizeof(T));
     _readCursor += vectorSize * sizeof(T);
 
     return ret;
@@ -214,19 +234,19 @@ std::vector<T> modulight::MessageReader::readStdVector()
 template<typename T>
 QVector<T> modulight::MessageReader::readQVector()
 {
-    if (_readCursor + (int)sizeof(unsigned int) > _data.size())
+    if (_readCursor + (int)sizeof(unsigned int) > _size)
         throw Exception("Bad Message::readVector : out of bounds");
 
     unsigned int vectorSize;
 
-    memcpy(&vectorSize, &_data[_readCursor], sizeof(unsigned int));
+    memcpy(&vectorSize, _data + _readCursor, sizeof(unsigned int));
     _readCursor += sizeof(unsigned int);
 
-    if (_readCursor + (int)(vectorSize*sizeof(T)) > _data.size())
+    if (_readCursor + (int)(vectorSize*sizeof(T)) > _size)
         throw Exception("Bad Message::readVector : critical internal error in the written string");
 
     QVector<T> ret(vectorSize);
-    memcpy(ret.data(), &_data[_readCursor], vectorSize * sizeof(T));
+    memcpy(ret.data(), _data + _readCursor, vectorSize * sizeof(T));
     _readCursor += vectorSize * sizeof(T);
 
     return ret;
@@ -235,12 +255,12 @@ QVector<T> modulight::MessageReader::readQVector()
 template<typename T>
 T modulight::MessageReader::read()
 {
-    if (_readCursor + (int)sizeof(T) > _data.size())
+    if (_readCursor + (int)sizeof(T) > _size)
         throw Exception("Bad Message::read : out of bounds");
 
     T ret;
 
-    memcpy(&ret, &_data[_readCursor], sizeof(T));
+    memcpy(&ret, _data + _readCursor, sizeof(T));
     _readCursor += sizeof(T);
 
     return ret;
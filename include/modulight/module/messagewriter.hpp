@@ -9,6 +9,7 @@
 
 namespace modulight
 {
+class Module;
 /**
  * \addtogroup groupModule
  * @{
@@ -20,6 +21,7 @@ namespace modulight
  */
 class MessageWriter
 {
+    friend class modulight::Module;
 public:
     /**
      * @brief Constructor
@@ -1,54 +1,374 @@
 #ifndef PORT_HPP
 #define PORT_HPP
 
+#include <QList>
 #include <QVector>
 #include <QString>
+#include <QSharedPointer>
 #include <QRegExp>
 #include <QStringList>
+#include <QMap>
+#include <QTime>
+
+#include <cstring>
 
 #include <zmq.hpp>
 
 #include <modulight/common/modulightexception.hpp>
+#include <modulight/common/queuepolicy.hpp>
 #include <modulight/module/stamp.hpp>
+#include <modulight/module/sharedmemoryring.hpp>
+#include <modulight/module/sendqueue.hpp>
+#include <modulight/module/tokenbucket.hpp>
 
 namespace modulight
 {
 
+struct ReceivedMessage
+{
+    QSharedPointer<zmq::message_t> message;
+
+    quint32 sourceId;
+    int moduleIteration;
+    int portIteration;
+    qint64 sendTime; // See Stamp::sendTime()
+
+    bool inRing; // true => the content lies in a shared memory slot, which is held until the message is destroyed
+
+    ReceivedMessage() : inRing(false) {}
+};
+
+// A message waiting in the join buffer of its input port (see Module::join)
+struct JoinEntry
+{
+    ReceivedMessage message;
+    qint64 arrivalTime; // Milliseconds since epoch
+};
+
+// Lossy connections are credit based : the consumer sends a credit once it has read a message,
+// the producer pushes its newest message to a remote as soon as it has a credit from it.
+// Bounded lossless connections use the same channels, the consumer then sends queueBound credits at once when it connects
+struct LossyChannel
+{
+    QString remoteName; // For example, Module42:out
+    QByteArray endpoint;
+
+    zmq::socket_t * dealer; // Connected to the remote ROUTER socket, with lossyChannelIdentity() as identity
+
+    bool messageAvailable;
+};
+
+// The identity of a lossy channel DEALER socket, from which the producer finds the remote.
+// ZeroMQ identities must not start with a zero byte
+inline QByteArray lossyChannelIdentity(quint32 inputPortId)
+{
+    QByteArray identity(1 + sizeof(quint32), 'l');
+    memcpy(identity.data() + 1, &inputPortId, sizeof(quint32));
+    return identity;
+}
+
+// The topic an input port subscribes to (in addition to everything) on a shared memory connection.
+// The producer receives it on its XPUB socket, which tells it the port will get its descriptors from now on
+inline QByteArray sharedMemoryTopic(quint32 inputPortId)
+{
+    QByteArray topic(1 + sizeof(quint32), 's');
+    memcpy(topic.data() + 1, &inputPortId, sizeof(quint32));
+    return topic;
+}
+
+// The ring of a co-located output port, mapped by an input port
+struct SharedMemorySource
+{
+    QString ringName;
+    QSharedPointer<SharedMemoryRing> ring;
+    int reader; // Index of the input port among the ring readers
+};
+
 struct InputPort
 {
+    QString name;
+
     zmq::socket_t * sub;
-    zmq::socket_t * req;
+    zmq::socket_t * steeringSub; // 0 if the port has no steering lane
+    QVector<LossyChannel> lossyChannels;
 
     QByteArray completePortName; // For example, Bouh2:in
+    quint32 id; // Identifies the lossy channels of this port, see inputPortId()
 
     bool messageAvailableOnLossless;
-    bool messageAvailableOnLossy;
+    bool messageAvailableOnSteering;
 
     QStringList losslessRemotes;
-    QStringList lossyRemotes;
+    QMap<QString, QByteArray> steeringRemotes; // Remote name -> endpoint the steering lane is connected to
+
+    QList<ReceivedMessage> pendingMessages; // Received but not read yet (batch entries, conflated messages)
+
+    // Messages put aside while looking for the message of another source (see Module::readMessageFrom),
+    // or too big for the user buffer
+    QMap<quint32, QList<ReceivedMessage> > sourceMessages; // By source id
+    QList<quint32> sourceOrder; // Source id of every message of sourceMessages, in arrival order
+
+    QMap<int, JoinEntry> joinMessages; // By iteration number, received by Module::join but not released yet
+
+    QMap<quint32, SharedMemorySource> sharedMemorySources; // By source id
+
+    bool latestOnly; // true => only the newest message of each source is kept (see Module::setLatestOnly)
+
+    QMap<quint32, int> timeToLive; // By source id, in milliseconds, for the connections whose messages expire
+    quint64 expiredMessageCount;
+
+    InputPort() : sub(0), steeringSub(0), messageAvailableOnLossless(false), messageAvailableOnSteering(false), latestOnly(false),
+        expiredMessageCount(0) {}
+
+    bool messageAvailableOnLossy() const
+    {
+        for (int i = 0; i < lossyChannels.size(); ++i)
+            if (lossyChannels[i].messageAvailable)
+                return true;
+        return false;
+    }
+
+    bool messageAvailable() const
+    {
+        return messageAvailableOnSteering || !pendingMessages.isEmpty() || !sourceOrder.isEmpty() ||
+               messageAvailableOnLossless || messageAvailableOnLossy();
+    }
+
+    QStringList lossyRemotes() const
+    {
+        QStringList names;
+        for (int i = 0; i < lossyChannels.size(); ++i)
+            names.append(lossyChannels[i].remoteName);
+        return names;
+    }
 
-    InputPort() : sub(0), req(0) {}
+    int lossyChannelIndex(const QString & remoteName) const
+    {
+        for (int i = 0; i < lossyChannels.size(); ++i)
+            if (lossyChannels[i].remoteName == remoteName)
+                return i;
+        return -1;
+    }
+};
+
+// Decimation and sampling of the messages sent to a remote (see Application::connect), applied by the producer
+struct Sampler
+{
+    int decimation; // 1 => every message
+    double maxFrequency; // Messages per second, 0 => unlimited
+    int lastIteration; // Port iteration of the last accepted message, -1 => none yet
+    qint64 lastTime; // Send time of the last accepted message
+
+    Sampler(int decimation_ = 1, double maxFrequency_ = 0) :
+        decimation(decimation_), maxFrequency(maxFrequency_), lastIteration(-1), lastTime(0) {}
+
+    bool isEnabled() const { return decimation > 1 || maxFrequency > 0; }
+
+    bool accept(const Stamp & stamp)
+    {
+        if (lastIteration != -1)
+        {
+            if (stamp.portIteration() - lastIteration < decimation)
+                return false;
+
+            if (maxFrequency > 0 && (stamp.sendTime() - lastTime) * maxFrequency < 1000)
+                return false;
+        }
+
+        lastIteration = stamp.portIteration();
+        lastTime = stamp.sendTime();
+        return true;
+    }
+};
+
+struct LossyRemote
+{
+    QString name; // For example, Bouh2:in
+    quint32 id; // Input port id of the remote, see lossyChannelIdentity()
+    QByteArray identity;
+    bool sent; // true => the current message had been sent to the remote
+    bool credit; // true => the remote is ready to receive a message
+    bool sharedMemory; // true => the remote is co-located and receives descriptors of the ring slots
+    int msTimeToLive; // A last message older than this is not pushed, 0 => messages never expire
+    Sampler sampler;
+
+    // With sampling, the last message accepted by the sampler, pushed once the remote has a credit.
+    // Remotes without sampling are pushed the last message of the port
+    QSharedPointer<zmq::message_t> sampledMessage;
+    Stamp sampledStamp;
+};
+
+struct QueuedMessage
+{
+    Stamp stamp;
+    QSharedPointer<zmq::message_t> message;
+};
+
+// A lossless connection whose queue is bounded. The producer queues at most bound messages for the remote,
+// and pushes them as the remote credits arrive (each credit frame is empty, or holds a qint32 number of credits)
+struct BoundedRemote
+{
+    QString name; // For example, Bouh2:in
+    quint32 id; // Input port id of the remote, see lossyChannelIdentity()
+    QByteArray identity;
+    int bound;
+    QueuePolicy::QueuePolicy policy;
+    int credits; // Number of messages the remote can receive right now
+    QList<QueuedMessage> queue;
+    bool degraded; // QueuePolicy::ADAPTIVE : true => the remote is too slow, only the newest message is queued
+    int msTimeToLive; // Queued messages older than this are dropped, 0 => messages never expire
+    Sampler sampler;
+};
+
+struct SharedMemoryReader
+{
+    QString name; // For example, Bouh2:in
+    quint32 id; // Input port id of the remote
+    bool lossless;
+    bool active; // true => the remote subscription had been received, it gets every descriptor from now on
 };
 
 struct OutputPort
 {
+    QString name;
+
     zmq::socket_t * pub;
-    zmq::socket_t * rep;
+    zmq::socket_t * router; // Lossy connections
+    zmq::socket_t * shmPub; // Lossless co-located connections (XPUB), which receive descriptors of the ring slots
+    zmq::socket_t * steeringPub; // Steering lane (see Module::sendSteering), 0 if the port has none
 
     quint16 pubPort;
-    quint16 repPort;
+    quint16 routerPort;
+    quint16 steeringPort;
+
+    QString pubIpc; // Empty if no ipc:// endpoint could be bound
+    QString routerIpc;
+    QString shmPubIpc;
+    QString steeringIpc;
 
     QByteArray completePortName; // For example, Module42:out
+    quint32 id; // Carried in stamps, see outputPortId()
 
-    QVector<char> lastMessageBuffer;
+    // Last message, shared with the messages pushed to lossy remotes (never modified once sent)
+    QSharedPointer<zmq::message_t> lastMessage;
     Stamp lastStamp;
 
+    // Ring in which the large messages sent to co-located remotes are written
+    QSharedPointer<SharedMemoryRing> ring;
+    QList<QSharedPointer<SharedMemoryRing> > retiredRings; // Replaced by a bigger ring, kept linked until readers released their slots
+    int ringGeneration;
+    bool ringFailed; // true => the ring could not be created, messages are sent inline
+    bool ringStalled; // true => a reader did not release its slots in time, messages are sent inline until a slot is free
+    qint64 ringSequence;
+    int lastSlot;
+    bool lastInRing; // true => lastDescriptor describes the last message
+    SharedMemoryDescriptor lastDescriptor;
+    QVector<SharedMemoryReader> sharedMemoryReaders;
+    QList<quint32> sharedMemorySubscribers; // Input port ids whose subscription had been received on shmPub
+
     QStringList losslessRemotes;
-    QMap<QString, bool> lossyRemotes; // true => the current message had been sent to the remote
+    QVector<LossyRemote> lossyRemotes;
+    QVector<BoundedRemote> boundedRemotes;
 
     int iterationNumber;
+    int steeringIterationNumber;
+    quint64 droppedMessageCount; // By the bounded remotes queues and the rate limit
+
+    // Batching (see Module::setBatching), disabled if batchMaxSize is 0
+    int batchMaxSize;
+    int msBatchDelay;
+    QVector<char> batch; // BatchEntry headers, each followed by its data
+    QTime batchTime; // Started when the first message of the batch had been appended
+
+    // Rate limit (see Module::setRateLimit)
+    TokenBucket rateLimiter;
+    QueuePolicy::QueuePolicy ratePolicy;
+    Stamp pacedStamp;
+    QSharedPointer<zmq::message_t> pacedMessage; // QueuePolicy::DROP_OLDEST : newest message waiting for tokens, null if none
+
+    QSharedPointer<SendQueue> sendQueue; // Messages posted from any thread (see Module::postMessage), not sent yet
+
+    OutputPort() : pub(0), router(0), shmPub(0), steeringPub(0), steeringPort(0), lastMessage(new zmq::message_t), ringGeneration(0),
+        ringFailed(false), ringStalled(false), ringSequence(0), lastSlot(-1), lastInRing(false), iterationNumber(-1), steeringIterationNumber(-1),
+        droppedMessageCount(0), batchMaxSize(0), msBatchDelay(0), ratePolicy(QueuePolicy::BLOCK), sendQueue(new SendQueue) {}
+
+    int lossyRemoteIndex(quint32 id) const
+    {
+        for (int i = 0; i < lossyRemotes.size(); ++i)
+            if (lossyRemotes[i].id == id)
+                return i;
+        return -1;
+    }
+
+    int lossyRemoteIndex(const QString & name) const
+    {
+        for (int i = 0; i < lossyRemotes.size(); ++i)
+            if (lossyRemotes[i].name == name)
+                return i;
+        return -1;
+    }
+
+    void addLossyRemote(const QString & name, quint32 id, bool sharedMemory, int msTimeToLive, const Sampler & sampler)
+    {
+        LossyRemote remote;
+        remote.name = name;
+        remote.id = id;
+        remote.identity = lossyChannelIdentity(id);
+        remote.sent = true;
+        remote.credit = false;
+        remote.sharedMemory = sharedMemory;
+        remote.msTimeToLive = msTimeToLive;
+        remote.sampler = sampler;
+        lossyRemotes.append(remote);
+    }
+
+    int boundedRemoteIndex(quint32 id) const
+    {
+        for (int i = 0; i < boundedRemotes.size(); ++i)
+            if (boundedRemotes[i].id == id)
+                return i;
+        return -1;
+    }
+
+    int boundedRemoteIndex(const QString & name) const
+    {
+        for (int i = 0; i < boundedRemotes.size(); ++i)
+            if (boundedRemotes[i].name == name)
+                return i;
+        return -1;
+    }
+
+    void addBoundedRemote(const QString & name, quint32 id, int bound, QueuePolicy::QueuePolicy policy, int msTimeToLive,
+                          const Sampler & sampler)
+    {
+        BoundedRemote remote;
+        remote.name = name;
+        remote.id = id;
+        remote.identity = lossyChannelIdentity(id);
+        remote.bound = bound;
+        remote.policy = policy;
+        remote.credits = 0;
+        remote.degraded = false;
+        remote.msTimeToLive = msTimeToLive;
+        remote.sampler = sampler;
+        boundedRemotes.append(remote);
+    }
+
+    int sharedMemoryReaderIndex(const QString & name) const
+    {
+        for (int i = 0; i < sharedMemoryReaders.size(); ++i)
+            if (sharedMemoryReaders[i].name == name)
+                return i;
+        return -1;
+    }
 
-    OutputPort() : pub(0), rep(0), iterationNumber(-1) {}
+    bool hasLosslessSharedMemoryReader() const
+    {
+        for (int i = 0; i < sharedMemoryReaders.size(); ++i)
+            if (sharedMemoryReaders[i].lossless)
+                return true;
+        return false;
+    }
 };
 
 }
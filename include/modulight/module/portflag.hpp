@@ -0,0 +1,19 @@
+#ifndef PORTFLAG_HPP
+#define PORTFLAG_HPP
+
+namespace modulight
+{
+    namespace PortFlag
+    {
+        /**
+         * @brief Represents the options given to Module::addInputPort and Module::addOutputPort, which can be combined
+         */
+        enum PortFlag
+        {
+            NONE = 0x0, //!< A plain data port
+            STEERING_LANE = 0x1 //!< The port also has a steering lane for small urgent messages, see Module::sendSteering
+        };
+    }
+}
+
+#endif // PORTFLAG_HPP
@@ -0,0 +1,61 @@
+#ifndef PORTHANDLE_HPP
+#define PORTHANDLE_HPP
+
+namespace modulight
+{
+class Module;
+/**
+ * \addtogroup groupModule
+ * @{
+ */
+/**
+ * @brief Pre-resolved reference to a port of a Module
+ *
+ * A PortHandle is returned by Module::addInputPort() and Module::addOutputPort(), or can be obtained later with
+ * Module::inputPort() and Module::outputPort().<br/>
+ * Calling Module::send(), Module::readMessage(), Module::wait() or Module::messageAvailable() with a PortHandle instead of
+ * a port name avoids looking the port up by name on every call.<br/>
+ * <br/>
+ * A default-constructed PortHandle is invalid.
+ */
+class PortHandle
+{
+    friend class modulight::Module;
+public:
+    /**
+     * @brief Constructs an invalid PortHandle
+     */
+    PortHandle() : _index(-1), _isInput(false) {}
+
+    /**
+     * @brief Returns whether the PortHandle refers to a port
+     * @return true if the PortHandle refers to a port, false otherwise
+     */
+    bool isValid() const { return _index >= 0; }
+
+    /**
+     * @brief Returns whether the PortHandle refers to an input port
+     * @return true if the PortHandle refers to an input port, false if it refers to an output port or is invalid
+     */
+    bool isInput() const { return _isInput && _index >= 0; }
+
+    /**
+     * @brief Returns whether the PortHandle refers to an output port
+     * @return true if the PortHandle refers to an output port, false if it refers to an input port or is invalid
+     */
+    bool isOutput() const { return !_isInput && _index >= 0; }
+
+    bool operator==(const PortHandle & other) const { return _index == other._index && _isInput == other._isInput; }
+    bool operator!=(const PortHandle & other) const { return !(*this == other); }
+
+private:
+    PortHandle(int index, bool isInput) : _index(index), _isInput(isInput) {}
+
+private:
+    int _index;
+    bool _isInput;
+};
+/// @}
+}
+
+#endif // PORTHANDLE_HPP
@@ -0,0 +1,34 @@
+#ifndef PROGRESSTHREAD_HPP
+#define PROGRESSTHREAD_HPP
+
+#include <QAtomicInt>
+#include <QThread>
+
+namespace modulight
+{
+class Module;
+
+/**
+ * Background thread started by Module::startProgressThread.
+ *
+ * It periodically lets its Module handle lossy credits, expired batches and dynamic orders,
+ * so that they do not wait until user code calls a Module method.
+ */
+class ProgressThread : public QThread
+{
+public:
+    ProgressThread(Module * module, int msPeriod);
+
+    void stop(); //! Asks the thread to exit, it must still be waited for
+
+protected:
+    void run();
+
+private:
+    Module * _module;
+    int _msPeriod;
+    QAtomicInt _stopRequested;
+};
+}
+
+#endif // PROGRESSTHREAD_HPP
@@ -0,0 +1,19 @@
+#ifndef SENDMODE_HPP
+#define SENDMODE_HPP
+
+namespace modulight
+{
+    namespace SendMode
+    {
+        /**
+         * @brief Represents how Module::send(const QString &, const MessageWriter &) hands a MessageWriter buffer to ZeroMQ
+         */
+        enum SendMode
+        {
+            COPY, //!< ZeroMQ copies the MessageWriter buffer into its own message
+            ZERO_COPY //!< ZeroMQ sends the MessageWriter buffer itself and releases its reference on it once the message is sent
+        };
+    }
+}
+
+#endif // SENDMODE_HPP
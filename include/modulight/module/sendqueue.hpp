@@ -0,0 +1,41 @@
+#ifndef SENDQUEUE_HPP
+#define SENDQUEUE_HPP
+
+#include <atomic>
+
+#include <QVector>
+
+namespace modulight
+{
+/**
+ * Lock-free multi-producer single-consumer queue of the messages posted on an output port (see Module::postMessage).
+ *
+ * Producers push onto an atomic list head. The consumer takes the whole list at once, so there is no ABA problem,
+ * and reverses it to get the messages in the order they had been pushed.
+ */
+class SendQueue
+{
+public:
+    struct Message
+    {
+        QVector<char> data;
+        Message * next;
+    };
+
+    SendQueue() : _head(0) {}
+    ~SendQueue();
+
+    void push(Message * message); //! Thread-safe, takes the ownership of message
+    Message * takeAll(); //! Consumer side. Oldest message first, 0 if empty. The caller deletes the messages
+    bool isEmpty() const { return _head.load(std::memory_order_relaxed) == 0; }
+
+private:
+    SendQueue(const SendQueue &);
+    SendQueue & operator=(const SendQueue &);
+
+private:
+    std::atomic<Message *> _head; // Newest message first
+};
+}
+
+#endif // SENDQUEUE_HPP
@@ -0,0 +1,106 @@
+#ifndef SHAREDMEMORYRING_HPP
+#define SHAREDMEMORYRING_HPP
+
+#include <atomic>
+#include <cstddef>
+
+#include <QString>
+#include <QtGlobal>
+
+namespace modulight
+{
+/**
+ * Payload of the messages whose stamp is flagged as shared memory : the message content lies in a slot of a SharedMemoryRing.
+ *
+ * Its layout is fixed and it is sent as is, like Stamp.
+ */
+struct SharedMemoryDescriptor
+{
+    char ringName[48];
+    qint32 slot;
+    qint32 size;
+    qint64 sequence;
+
+    static bool fromData(const void * data, size_t size, SharedMemoryDescriptor & descriptor); //! false if data is not a descriptor
+};
+
+/**
+ * POSIX shared memory segment owned by an output port, split into slots in which messages are written.
+ *
+ * Readers are the co-located input ports connected to the output port. Each of them owns a bit in the mask of every slot,
+ * which is set while the reader may still access the slot content. The producer only reuses a slot once its mask is empty,
+ * which gives back-pressure to lossless connections.<br/>
+ * A lossless reader is only given its bit once its subscription reached the producer, as descriptors published before may not reach it.
+ * It ignores the descriptors older than its activation.<br/>
+ * <br/>
+ * The producer maps the whole segment read-write. Readers map the header read-write (to release slots) and the slots read-only.
+ * The segment name is unlinked when the producer destroys the ring, readers keep their mapping until they destroy theirs.
+ */
+class SharedMemoryRing
+{
+public:
+    static const int SLOT_COUNT = 4;
+    static const int MAX_READERS = 32;
+    static const int MIN_MESSAGE_SIZE = 64 * 1024; //! Smaller messages are sent inline, the descriptor would not pay off
+    static const int MAX_SLOT_WAIT = 1000; //! Milliseconds the producer waits for a free slot before sending the message inline
+
+    ~SharedMemoryRing();
+
+    static SharedMemoryRing * create(const QString & name, qint64 slotSize); //! Producer side, 0 on failure
+    static SharedMemoryRing * open(const QString & name); //! Reader side, 0 on failure
+
+    const QString & name() const { return _name; }
+    qint64 slotSize() const { return _slotSize; }
+
+    // Producer side
+    int addReader(quint32 inputPortId, bool lossless, bool active); //! -1 if there are too many readers
+    void activateReader(quint32 inputPortId, qint64 sequence);
+    void removeReader(quint32 inputPortId);
+    int acquireSlot(int previousSlot) const; //! -1 if every slot is still used by a reader
+    char * slotData(int slot);
+    void publishSlot(int slot, qint64 sequence);
+    void holdSlot(int slot, int reader);
+    bool isIdle() const; //! true if no reader uses any slot anymore
+
+    // Reader side
+    int readerIndex(quint32 inputPortId) const;
+    const char * slotData(int slot) const;
+    bool isActive(int reader, qint64 sequence) const; //! false if the reader was not active yet when the sequence was published
+    void releaseSlot(int slot, int reader);
+
+private:
+    struct Reader
+    {
+        std::atomic<quint32> inputPortId; // 0 => unused
+        std::atomic<quint32> lossless;
+        std::atomic<qint64> activeSince; // First sequence published since the reader is active
+    };
+
+    struct Header
+    {
+        quint32 magic;
+        qint32 slotCount;
+        qint64 slotSize;
+
+        std::atomic<qint64> sequences[SLOT_COUNT];
+        std::atomic<quint32> masks[SLOT_COUNT];
+
+        Reader readers[MAX_READERS];
+    };
+
+    SharedMemoryRing();
+
+    static size_t headerSize();
+    bool map(int fd, bool owner);
+
+private:
+    QString _name;
+    bool _owner;
+
+    Header * _header;
+    char * _slots;
+    qint64 _slotSize;
+};
+}
+
+#endif // SHAREDMEMORYRING_HPP
@@ -1,48 +1,61 @@
 #ifndef STAMP_HPP
 #define STAMP_HPP
 
-#include <QString>
+#include <QtGlobal>
 
 namespace modulight
 {
+/**
+ * Header sent as the first frame of every message.
+ *
+ * Its layout is fixed and it is sent as is, so building, copying and parsing a stamp never allocates.
+ * The source output port is identified by its numeric id (see outputPortId()), which receivers
+ * only resolve to a name when it is asked for.
+ */
 class Stamp
 {
 public:
     Stamp();
-    Stamp(bool realMessage, const QByteArray * source, int moduleIteration,
-          int portIteration, int userDataSize = 0, void * userData = 0);
-    Stamp(const Stamp & other);
-    Stamp & operator=(const Stamp & other);
+    Stamp(bool realMessage, quint32 sourceId, int moduleIteration, int portIteration);
 
-    ~Stamp();
+    int size() const { return sizeof(Stamp); }
+    const char * data() const { return reinterpret_cast<const char *>(this); }
 
-    int size() const { return _size; }
-    char * data() const { return _data; }
-
-    bool isReal() const { return _realMessage == 1; }
+    bool isReal() const { return (_flags & REAL_MESSAGE) != 0; }
+    bool isSharedMemory() const { return (_flags & SHARED_MEMORY) != 0; } //! The payload is a SharedMemoryDescriptor
+    void setSharedMemory(bool sharedMemory) { _flags = sharedMemory ? (_flags | SHARED_MEMORY) : (_flags & ~SHARED_MEMORY); }
+    bool isBatch() const { return (_flags & BATCH) != 0; } //! The payload is a sequence of BatchEntry, each followed by its data
+    void setBatch(bool batch) { _flags = batch ? (_flags | BATCH) : (_flags & ~BATCH); }
     int moduleIteration() const { return _moduleIteration; }
     int portIteration() const { return _portIteration; }
+    quint32 sourceId() const { return _sourceId; }
+    qint64 sendTime() const { return _sendTime; } //! When the stamp had been built, in milliseconds since the epoch
 
-    static void extractUsefulInformationFromData(char * data,
-                                                 int & moduleIteration, int & portIteration,
-                                                 bool & isReal, QString & source);
-
-private:
-    int calculateSize();
-    void copyDataTo(char * dest);
+    static bool fromData(const void * data, size_t size, Stamp & stamp); //! false if data is not a stamp
 
 private:
-    int _moduleIteration;
-    int _portIteration;
-    int _realMessage; //1 if the message is real, 0 otherwise
-
-    const QByteArray * _source;
-
-    int _userDataSize;
-    void * _userData;
+    enum Flag
+    {
+        REAL_MESSAGE = 0x1,
+        SHARED_MEMORY = 0x2,
+        BATCH = 0x4
+    };
+
+    qint32 _moduleIteration;
+    qint32 _portIteration;
+    quint32 _sourceId;
+    quint32 _flags;
+    qint64 _sendTime;
+};
 
-    char * _data;
-    int _size;
+/**
+ * Header of each logical message within a batch (see Module::setBatching), followed by the message data.
+ */
+struct BatchEntry
+{
+    qint32 moduleIteration;
+    qint32 portIteration;
+    qint32 size;
 };
 }
 
@@ -0,0 +1,41 @@
+#ifndef TOKENBUCKET_HPP
+#define TOKENBUCKET_HPP
+
+#include <QElapsedTimer>
+
+namespace modulight
+{
+/**
+ * Token bucket limiting the rate of the messages sent on an output port (see Module::setRateLimit), in messages/s and in bytes/s.
+ *
+ * Each bucket holds at most a tenth of a second of its rate, which bounds the bursts.
+ * A message is let through as soon as the buckets hold its tokens, or are full if it is larger than them.
+ * The bytes bucket may then go into debt, which delays the next messages accordingly.
+ */
+class TokenBucket
+{
+public:
+    TokenBucket();
+
+    void setRate(double messagesPerSecond, double bytesPerSecond); //! 0 disables the corresponding limit
+    bool isEnabled() const { return _messageRate > 0 || _byteRate > 0; }
+
+    bool consume(int size); //! false if the message cannot be sent yet, nothing is consumed then
+    int msUntilAvailable(int size) const; //! 0 if the message can be sent right now
+
+private:
+    double messageTokens() const; // Tokens held right now
+    double byteTokens() const;
+    void refill();
+
+private:
+    double _messageRate;
+    double _byteRate;
+    double _messageTokens;
+    double _byteTokens;
+
+    QElapsedTimer _timer; // Started at the last refill
+};
+}
+
+#endif // TOKENBUCKET_HPP
@@ -0,0 +1,19 @@
+#ifndef WAITMODE_HPP
+#define WAITMODE_HPP
+
+namespace modulight
+{
+    namespace WaitMode
+    {
+        /**
+         * @brief Represents how a module waits for messages in Module::wait
+         */
+        enum WaitMode
+        {
+            BLOCKING, //!< The module blocks on its sockets until a message or a lossy request arrives, or until the timeout expires
+            POLLING //!< The module polls its sockets without blocking then sleeps between two tries
+        };
+    }
+}
+
+#endif // WAITMODE_HPP
@@ -8,7 +8,7 @@ QT = core xml network
 DESTDIR = lib
 OBJECTS_DIR = .obj
 
-LIBS += -lzmq
+LIBS += -lzmq -lrt
 
 include (mpi.pro)
 
@@ -49,9 +49,20 @@ HEADERS +=  include/modulight/common/xml.hpp \
     include/modulight/master/masterconnection.hpp \
     include/modulight/application.hpp \
     include/modulight/common/modulightexception.hpp \
+    include/modulight/common/portid.hpp \
+    include/modulight/common/queuepolicy.hpp \
     include/modulight/master/userinterface.hpp \
     include/modulight/module/stamp.hpp \
-    include/modulight/module/modulestate.hpp
+    include/modulight/module/modulestate.hpp \
+    include/modulight/module/waitmode.hpp \
+    include/modulight/module/sendmode.hpp \
+    include/modulight/module/portflag.hpp \
+    include/modulight/module/joinpolicy.hpp \
+    include/modulight/module/porthandle.hpp \
+    include/modulight/module/sharedmemoryring.hpp \
+    include/modulight/module/progressthread.hpp \
+    include/modulight/module/sendqueue.hpp \
+    include/modulight/module/tokenbucket.hpp
             
 SOURCES += src/common/xml.cpp \
     src/module/module.cpp \
@@ -67,4 +78,8 @@ SOURCES += src/common/xml.cpp \
     src/master/reachableexecutables.cpp \
     src/master/masterconnection.cpp \
     src/master/application.cpp \
-    src/module/stamp.cpp
+    src/module/stamp.cpp \
+    src/module/sharedmemoryring.cpp \
+    src/module/progressthread.cpp \
+    src/module/sendqueue.cpp \
+    src/module/tokenbucket.cpp
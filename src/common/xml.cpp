@@ -48,6 +48,7 @@ void modulight::xml::writeArguments(QString & xml, const QMap<QString, QString>
 void modulight::xml::readModuleDescription(const QString & xml, ModuleDescription & description)
 {
     description.inputPorts.clear();
+    description.steeringInputPorts.clear();
     description.outputPorts.clear();
 
     QDomDocument doc;
@@ -65,6 +66,9 @@ void modulight::xml::readModuleDescription(const QString & xml, ModuleDescriptio
         if(child.nodeName() == "iport")
         {
             description.inputPorts.append(child.attribute("name"));
+
+            if (child.attribute("steeringLane").toInt())
+                description.steeringInputPorts.append(child.attribute("name"));
         }
         else if(child.nodeName() == "oport")
         {
@@ -72,6 +76,12 @@ void modulight::xml::readModuleDescription(const QString & xml, ModuleDescriptio
 
             o.losslessPort = child.attribute("losslessPort").toInt();
             o.lossyPort = child.attribute("lossyPort").toInt();
+            o.index = child.attribute("index").toInt();
+            o.losslessIpc = child.attribute("losslessIpc");
+            o.lossyIpc = child.attribute("lossyIpc");
+            o.sharedMemoryIpc = child.attribute("sharedMemoryIpc");
+            o.steeringPort = child.attribute("steeringPort").toInt();
+            o.steeringIpc = child.attribute("steeringIpc");
 
             description.outputPorts[child.attribute("name")] = o;
         }
@@ -93,6 +103,7 @@ void modulight::xml::writeModuleDescription(QString & xml, const ModuleDescripti
     {
         QDomElement iport = doc.createElement("iport");
         iport.setAttribute("name", inputPort);
+        iport.setAttribute("steeringLane", description.steeringInputPorts.contains(inputPort));
         docelem.appendChild(iport);
     }
 
@@ -105,6 +116,12 @@ void modulight::xml::writeModuleDescription(QString & xml, const ModuleDescripti
         oport.setAttribute("name", it.key());
         oport.setAttribute("losslessPort", it.value().losslessPort);
         oport.setAttribute("lossyPort", it.value().lossyPort);
+        oport.setAttribute("index", it.value().index);
+        oport.setAttribute("losslessIpc", it.value().losslessIpc);
+        oport.setAttribute("lossyIpc", it.value().lossyIpc);
+        oport.setAttribute("sharedMemoryIpc", it.value().sharedMemoryIpc);
+        oport.setAttribute("steeringPort", it.value().steeringPort);
+        oport.setAttribute("steeringIpc", it.value().steeringIpc);
 
         docelem.appendChild(oport);
     }
@@ -129,11 +146,18 @@ void modulight::xml::readSequence(const QString & xml, Sequence & sequence)
             Connection c;
             c.isConnect = true;
             c.isLossy = child.attribute("lossy").toInt();
+            c.isSharedMemory = child.attribute("sharedMemory").toInt();
             c.localPortName = child.attribute("localPortName");
             c.remoteIP = child.attribute("remoteIP");
             c.remotePort = child.attribute("remotePort").toInt();
             c.syncPort = child.attribute("syncPort").toInt();
+            c.remoteIpc = child.attribute("remoteIpc");
             c.remoteAbbrevName = child.attribute("remoteAbbrevName");
+            c.remoteId = child.attribute("remoteId").toUInt();
+            c.queueBound = child.attribute("queueBound").toInt();
+            c.msTimeToLive = child.attribute("msTimeToLive").toInt();
+            c.steeringPort = child.attribute("steeringPort").toInt();
+            c.steeringIpc = child.attribute("steeringIpc");
 
             sequence.connections.append(c);
         }
@@ -142,8 +166,15 @@ void modulight::xml::readSequence(const QString & xml, Sequence & sequence)
             Connection c;
             c.isConnect = false;
             c.isLossy = child.attribute("lossy").toInt();
+            c.isSharedMemory = child.attribute("sharedMemory").toInt();
             c.localPortName = child.attribute("localPortName");
             c.remoteAbbrevName = child.attribute("remoteAbbrevName");
+            c.remoteId = child.attribute("remoteId").toUInt();
+            c.queueBound = child.attribute("queueBound").toInt();
+            c.msTimeToLive = child.attribute("msTimeToLive").toInt();
+            c.queuePolicy = (QueuePolicy::QueuePolicy) child.attribute("queuePolicy").toInt();
+            c.decimation = child.attribute("decimation", "1").toInt();
+            c.maxFrequency = child.attribute("maxFrequency", "0").toDouble();
 
             sequence.connections.append(c);
         }
@@ -162,11 +193,18 @@ void modulight::xml::writeSequence(QString & xml, const Sequence & sequence, int
         {
             QDomElement node = doc.createElement("connect");
             node.setAttribute("lossy", c.isLossy);
+            node.setAttribute("sharedMemory", c.isSharedMemory);
             node.setAttribute("localPortName", c.localPortName);
             node.setAttribute("remoteIP", c.remoteIP);
             node.setAttribute("remotePort", c.remotePort);
             node.setAttribute("syncPort", c.syncPort);
+            node.setAttribute("remoteIpc", c.remoteIpc);
             node.setAttribute("remoteAbbrevName", c.remoteAbbrevName);
+            node.setAttribute("remoteId", c.remoteId);
+            node.setAttribute("queueBound", c.queueBound);
+            node.setAttribute("msTimeToLive", c.msTimeToLive);
+            node.setAttribute("steeringPort", c.steeringPort);
+            node.setAttribute("steeringIpc", c.steeringIpc);
 
             docElem.appendChild(node);
         }
@@ -174,8 +212,15 @@ void modulight::xml::writeSequence(QString & xml, const Sequence & sequence, int
         {
             QDomElement node = doc.createElement("accept");
             node.setAttribute("lossy", c.isLossy);
+            node.setAttribute("sharedMemory", c.isSharedMemory);
             node.setAttribute("localPortName", c.localPortName);
             node.setAttribute("remoteAbbrevName", c.remoteAbbrevName);
+            node.setAttribute("remoteId", c.remoteId);
+            node.setAttribute("queueBound", c.queueBound);
+            node.setAttribute("msTimeToLive", c.msTimeToLive);
+            node.setAttribute("queuePolicy", c.queuePolicy);
+            node.setAttribute("decimation", c.decimation);
+            node.setAttribute("maxFrequency", c.maxFrequency);
 
             docElem.appendChild(node);
         }
@@ -328,6 +373,11 @@ void modulight::xml::readDynamicRequests(const QString & xml, DynamicRequestSequ
         {
             req.type = ADD_CONNECTION;
             req.lossyConnection = child.attribute("lossyConnection").toInt();
+            req.queueBound = child.attribute("queueBound").toInt();
+            req.msTimeToLive = child.attribute("msTimeToLive").toInt();
+            req.queuePolicy = (QueuePolicy::QueuePolicy) child.attribute("queuePolicy").toInt();
+            req.decimation = child.attribute("decimation", "1").toInt();
+            req.maxFrequency = child.attribute("maxFrequency", "0").toDouble();
 
             QDomElement conchild = child.firstChild().toElement();
             for(; !conchild.isNull(); conchild = conchild.nextSibling().toElement())
@@ -417,6 +467,11 @@ void modulight::xml::writeDynamicRequests(QString & xml, const DynamicRequestSeq
         {
             req.setTagName("add_connection");
             req.setAttribute("lossyConnection", it->lossyConnection);
+            req.setAttribute("queueBound", it->queueBound);
+            req.setAttribute("msTimeToLive", it->msTimeToLive);
+            req.setAttribute("queuePolicy", it->queuePolicy);
+            req.setAttribute("decimation", it->decimation);
+            req.setAttribute("maxFrequency", it->maxFrequency);
 
             QDomElement src = doc.createElement("source");
             src.setAttribute("name",it->sourceName);
@@ -480,7 +535,14 @@ void modulight::xml::readDynamicOrders(const QString & xml, DynamicOrderSequence
             order.type = ACCEPT;
             order.localPortName = child.attribute("localPortName");
             order.remoteAbbrevName = child.attribute("remoteAbbrevName");
+            order.remoteId = child.attribute("remoteId").toUInt();
             order.lossyConnection = child.attribute("lossyConnection").toInt();
+            order.sharedMemory = child.attribute("sharedMemory").toInt();
+            order.queueBound = child.attribute("queueBound").toInt();
+            order.msTimeToLive = child.attribute("msTimeToLive").toInt();
+            order.queuePolicy = (QueuePolicy::QueuePolicy) child.attribute("queuePolicy").toInt();
+            order.decimation = child.attribute("decimation", "1").toInt();
+            order.maxFrequency = child.attribute("maxFrequency", "0").toDouble();
         }
         else if(child.nodeName() == "connect")
         {
@@ -490,7 +552,14 @@ void modulight::xml::readDynamicOrders(const QString & xml, DynamicOrderSequence
             order.remoteIP = child.attribute("remoteIP");
             order.remotePort = child.attribute("remotePort").toInt();
             order.syncPort = child.attribute("syncPort").toInt();
+            order.remoteIpc = child.attribute("remoteIpc");
+            order.remoteId = child.attribute("remoteId").toUInt();
             order.lossyConnection = child.attribute("lossyConnection").toInt();
+            order.sharedMemory = child.attribute("sharedMemory").toInt();
+            order.queueBound = child.attribute("queueBound").toInt();
+            order.msTimeToLive = child.attribute("msTimeToLive").toInt();
+            order.steeringPort = child.attribute("steeringPort").toInt();
+            order.steeringIpc = child.attribute("steeringIpc");
         }
         else if(child.nodeName() == "idisconnect")
         {
@@ -500,6 +569,8 @@ void modulight::xml::readDynamicOrders(const QString & xml, DynamicOrderSequence
             order.remoteIP = child.attribute("remoteIP");
             order.remotePort = child.attribute("remotePort").toInt();
             order.syncPort = child.attribute("syncPort").toInt();
+            order.remoteIpc = child.attribute("remoteIpc");
+            order.remoteId = child.attribute("remoteId").toUInt();
             order.lossyConnection = child.attribute("lossyConnection").toInt();
         }
         else if(child.nodeName() == "odisconnect")
@@ -534,7 +605,14 @@ void modulight::xml::writeDynamicOrders(QString & xml, const DynamicOrderSequenc
             ord.setTagName("accept");
             ord.setAttribute("localPortName", o.localPortName);
             ord.setAttribute("remoteAbbrevName", o.remoteAbbrevName);
+            ord.setAttribute("remoteId", o.remoteId);
             ord.setAttribute("lossyConnection", o.lossyConnection);
+            ord.setAttribute("sharedMemory", o.sharedMemory);
+            ord.setAttribute("queueBound", o.queueBound);
+            ord.setAttribute("msTimeToLive", o.msTimeToLive);
+            ord.setAttribute("queuePolicy", o.queuePolicy);
+            ord.setAttribute("decimation", o.decimation);
+            ord.setAttribute("maxFrequency", o.maxFrequency);
             break;
         case CONNECT:
             ord.setTagName("connect");
@@ -543,7 +621,14 @@ void modulight::xml::writeDynamicOrders(QString & xml, const DynamicOrderSequenc
             ord.setAttribute("remoteIP", o.remoteIP);
             ord.setAttribute("remotePort", o.remotePort);
             ord.setAttribute("syncPort", o.syncPort);
+            ord.setAttribute("remoteIpc", o.remoteIpc);
+            ord.setAttribute("remoteId", o.remoteId);
             ord.setAttribute("lossyConnection", o.lossyConnection);
+            ord.setAttribute("sharedMemory", o.sharedMemory);
+            ord.setAttribute("queueBound", o.queueBound);
+            ord.setAttribute("msTimeToLive", o.msTimeToLive);
+            ord.setAttribute("steeringPort", o.steeringPort);
+            ord.setAttribute("steeringIpc", o.steeringIpc);
             break;
         case INPUT_DISCONNECT:
             ord.setTagName("idisconnect");
@@ -552,6 +637,8 @@ void modulight::xml::writeDynamicOrders(QString & xml, const DynamicOrderSequenc
             ord.setAttribute("remoteIP", o.remoteIP);
             ord.setAttribute("remotePort", o.remotePort);
             ord.setAttribute("syncPort", o.syncPort);
+            ord.setAttribute("remoteIpc", o.remoteIpc);
+            ord.setAttribute("remoteId", o.remoteId);
             ord.setAttribute("lossyConnection", o.lossyConnection);
             break;
         case OUTPUT_DISCONNECT:
@@ -17,6 +17,7 @@
 #include <modulight/common/xml.hpp>
 #include <modulight/common/dot.hpp>
 #include <modulight/common/modulightexception.hpp>
+#include <modulight/common/portid.hpp>
 
 #include <modulight/master/userinterface.hpp>
 
@@ -120,7 +121,9 @@ user_interface::ParallelProcess * modulight::Application::addParallelProcess(con
 
 void modulight::Application::connect(user_interface::Process *processA, const QString &portA,
                                      user_interface::Process *processB, const QString &portB,
-                                     bool lossyConnection)
+                                     bool lossyConnection, int queueBound,
+                                     QueuePolicy::QueuePolicy queuePolicy, int msTimeToLive,
+                                     int decimation, double maxFrequency)
 {
     if (!_userProcesses.contains(processA))
     {
@@ -133,6 +136,24 @@ void modulight::Application::connect(user_interface::Process *processA, const QS
         throw Exception("Connection error : process does not exist");
     }
 
+    if (queueBound < 0)
+    {
+        cerr << QString("Critical error : within connection %1, the queue bound is negative").arg(_pendingConnections.size()).toStdString();
+        throw Exception("Connection error : negative queue bound");
+    }
+
+    if (msTimeToLive < 0)
+    {
+        cerr << QString("Critical error : within connection %1, the time to live is negative").arg(_pendingConnections.size()).toStdString();
+        throw Exception("Connection error : negative time to live");
+    }
+
+    if (decimation < 1 || maxFrequency < 0)
+    {
+        cerr << QString("Critical error : within connection %1, invalid sampling").arg(_pendingConnections.size()).toStdString();
+        throw Exception("Connection error : invalid sampling");
+    }
+
     MasterConnection c;
 
     c.processA = processA->id();
@@ -140,6 +161,14 @@ void modulight::Application::connect(user_interface::Process *processA, const QS
     c.processB = processB->id();
     c.portB = portB;
     c.lossy = lossyConnection;
+    c.queueBound = queueBound;
+    c.queuePolicy = queuePolicy;
+    c.msTimeToLive = msTimeToLive;
+    c.decimation = decimation;
+    c.maxFrequency = maxFrequency;
+
+    if (!lossyConnection && queueBound == 0 && c.isSampled())
+        c.queueBound = MasterConnection::SAMPLED_QUEUE_BOUND;
 
     if (_pendingConnections.contains(c))
     {
@@ -152,7 +181,9 @@ void modulight::Application::connect(user_interface::Process *processA, const QS
 
 void modulight::Application::connect(user_interface::Process *processA, const QString &portA,
                           user_interface::ParallelProcess *processB, const QString &portB,
-                          bool lossyConnection)
+                          bool lossyConnection, int queueBound,
+                          QueuePolicy::QueuePolicy queuePolicy, int msTimeToLive,
+                          int decimation, double maxFrequency)
 {
     if (!_userProcesses.contains(processA))
     {
@@ -165,6 +196,24 @@ void modulight::Application::connect(user_interface::Process *processA, const QS
         throw Exception("Connection error : process does not exist");
     }
 
+    if (queueBound < 0)
+    {
+        cerr << QString("Critical error : within connection %1, the queue bound is negative").arg(_pendingConnections.size()).toStdString();
+        throw Exception("Connection error : negative queue bound");
+    }
+
+    if (msTimeToLive < 0)
+    {
+        cerr << QString("Critical error : within connection %1, the time to live is negative").arg(_pendingConnections.size()).toStdString();
+        throw Exception("Connection error : negative time to live");
+    }
+
+    if (decimation < 1 || maxFrequency < 0)
+    {
+        cerr << QString("Critical error : within connection %1, invalid sampling").arg(_pendingConnections.size()).toStdString();
+        throw Exception("Connection error : invalid sampling");
+    }
+
     for (int i = 0; i < processB->size(); ++i)
     {
         MasterConnection c;
@@ -174,6 +223,14 @@ void modulight::Application::connect(user_interface::Process *processA, const QS
         c.processB = processB->ids()[i];
         c.portB = portB;
         c.lossy = lossyConnection;
+        c.queueBound = queueBound;
+        c.queuePolicy = queuePolicy;
+        c.msTimeToLive = msTimeToLive;
+        c.decimation = decimation;
+        c.maxFrequency = maxFrequency;
+
+        if (!lossyConnection && queueBound == 0 && c.isSampled())
+            c.queueBound = MasterConnection::SAMPLED_QUEUE_BOUND;
 
         if (_pendingConnections.contains(c))
         {
@@ -187,7 +244,9 @@ void modulight::Application::connect(user_interface::Process *processA, const QS
 
 void modulight::Application::connect(user_interface::ParallelProcess *processA, const QString &portA,
                           user_interface::Process *processB, const QString &portB,
-                          bool lossyConnection)
+                          bool lossyConnection, int queueBound,
+                          QueuePolicy::QueuePolicy queuePolicy, int msTimeToLive,
+                          int decimation, double maxFrequency)
 {
     if (!_userParallelProcesses.contains(processA))
     {
@@ -200,6 +259,24 @@ void modulight::Application::connect(user_interface::ParallelProcess *processA,
         throw Exception("Connection error : process does not exist");
     }
 
+    if (queueBound < 0)
+    {
+        cerr << QString("Critical error : within connection %1, the queue bound is negative").arg(_pendingConnections.size()).toStdString();
+        throw Exception("Connection error : negative queue bound");
+    }
+
+    if (msTimeToLive < 0)
+    {
+        cerr << QString("Critical error : within connection %1, the time to live is negative").arg(_pendingConnections.size()).toStdString();
+        throw Exception("Connection error : negative time to live");
+    }
+
+    if (decimation < 1 || maxFrequency < 0)
+    {
+        cerr << QString("Critical error : within connection %1, invalid sampling").arg(_pendingConnections.size()).toStdString();
+        throw Exception("Connection error : invalid sampling");
+    }
+
     for (int i = 0; i < processA->size(); ++i)
     {
         MasterConnection c;
@@ -209,6 +286,14 @@ void modulight::Application::connect(user_interface::ParallelProcess *processA,
         c.processB = processB->id();
         c.portB = portB;
         c.lossy = lossyConnection;
+        c.queueBound = queueBound;
+        c.queuePolicy = queuePolicy;
+        c.msTimeToLive = msTimeToLive;
+        c.decimation = decimation;
+        c.maxFrequency = maxFrequency;
+
+        if (!lossyConnection && queueBound == 0 && c.isSampled())
+            c.queueBound = MasterConnection::SAMPLED_QUEUE_BOUND;
 
         if (_pendingConnections.contains(c))
         {
@@ -342,6 +427,33 @@ void modulight::Application::setArgument(user_interface::ParallelProcess *proces
     }
 }
 
+void modulight::Application::setRateLimit(user_interface::Process *process, const QString &port, double messagesPerSecond,
+                                          double bytesPerSecond, QueuePolicy::QueuePolicy policy)
+{
+    if (!containsProcess(process->id()))
+    {
+        cerr << "Critical error : on setRateLimit, process does not exist" << endl;
+        throw Exception("Argument error : invalid process");
+    }
+
+    Process & p = processById(process->id());
+    QString prefix = QString("modulight.rateLimit.%1.").arg(port);
+
+    p.args.addDouble(prefix + "messages", messagesPerSecond);
+    p.args.addDouble(prefix + "bytes", bytesPerSecond);
+    p.args.addInt(prefix + "policy", policy);
+}
+
+void modulight::Application::setRateLimit(user_interface::ParallelProcess *process, const QString &port, double messagesPerSecond,
+                                          double bytesPerSecond, QueuePolicy::QueuePolicy policy)
+{
+    QString prefix = QString("modulight.rateLimit.%1.").arg(port);
+
+    setArgument(process, prefix + "messages", messagesPerSecond);
+    setArgument(process, prefix + "bytes", bytesPerSecond);
+    setArgument(process, prefix + "policy", (int)policy);
+}
+
 void modulight::Application::allowProcessToAlterNetwork(user_interface::Process * process)
 {
     if (!containsProcess(process->id()))
@@ -500,8 +612,8 @@ void modulight::Application::launchProcesses()
         else
             instance = ++_commandCounter[p.command];
 
-        QString host = _hostfile.hostOf(p.command, instance);
-        hosts.push_back(host.toUtf8());
+        p.host = _hostfile.hostOf(p.command, instance);
+        hosts.push_back(p.host.toUtf8());
 
         MPI_Info_create(&infos[i]);
         MPI_Info_set(infos[i], hostQBA.data(), hosts.back().data());
@@ -581,9 +693,13 @@ void modulight::Application::handleInstanceInformation()
     }
 
     for (int i = 0; i < _processes.size(); ++i)
-        MPI_Send(&_processes[i].instanceNumber, 1, MPI_INT,
+    {
+        int instanceInfo[2] = {_processes[i].instanceNumber, _processes[i].id};
+
+        MPI_Send(instanceInfo, 2, MPI_INT,
                  _processes[i].rank, tag::INSTANCE_INFO,
                  _processes[i].comm);
+    }
 }
 
 void modulight::Application::checkPorts()
@@ -633,19 +749,35 @@ void modulight::Application::handleOrders()
         cB.remoteIP = pA.description.ip;
         cB.syncPort = pA.description.syncPort;
         cB.remoteAbbrevName = QString("%1%2:%3").arg(pA.description.name).arg(pA.instanceNumber).arg(_pendingConnections[i].portA);
+        cB.remoteId = outputPortId(pA.id, pA.description.outputPorts[_pendingConnections[i].portA].index);
+        cB.queueBound = _pendingConnections[i].isBounded() ? _pendingConnections[i].queueBound : 0;
+        cB.msTimeToLive = _pendingConnections[i].msTimeToLive;
 
-        if (_pendingConnections[i].lossy)
+        bool creditBased = _pendingConnections[i].lossy || _pendingConnections[i].isBounded();
+
+        if (creditBased)
             cB.remotePort = pA.description.outputPorts[_pendingConnections[i].portA].lossyPort;
         else
             cB.remotePort = pA.description.outputPorts[_pendingConnections[i].portA].losslessPort;
 
+        cB.remoteIpc = ipcEndpoint(pA, _pendingConnections[i].portA, creditBased, pB);
+        cB.isSharedMemory = !_pendingConnections[i].isBounded() && usesSharedMemory(pA, _pendingConnections[i].portA, pB);
+        steeringEndpoint(pA, _pendingConnections[i].portA, pB, _pendingConnections[i].portB, cB.steeringPort, cB.steeringIpc);
+
         map[pB].connections.append(cB);
 
         Connection cA;
         cA.isConnect = false;
         cA.isLossy = _pendingConnections[i].lossy;
+        cA.isSharedMemory = cB.isSharedMemory;
         cA.localPortName = _pendingConnections[i].portA;
         cA.remoteAbbrevName = QString("%1%2:%3").arg(pB.description.name).arg(pB.instanceNumber).arg(_pendingConnections[i].portB);
+        cA.remoteId = inputPortId(pB.id, pB.description.inputPorts.indexOf(_pendingConnections[i].portB));
+        cA.queueBound = cB.queueBound;
+        cA.queuePolicy = _pendingConnections[i].queuePolicy;
+        cA.msTimeToLive = cB.msTimeToLive;
+        cA.decimation = _pendingConnections[i].decimation;
+        cA.maxFrequency = _pendingConnections[i].maxFrequency;
         map[pA].connections.append(cA);
     }
 
@@ -817,12 +949,15 @@ void modulight::Application::dynamicLoop()
                         orderB.remoteAbbrevName = QString("%1%2:%3").arg(pA.description.name).arg(pA.instanceNumber).arg(c.portA);
                         orderB.remoteIP = pA.description.ip;
                         orderB.syncPort = pA.description.syncPort;
+                        orderB.remoteId = outputPortId(pA.id, pA.description.outputPorts[c.portA].index);
 
-                        if (c.lossy)
+                        if (c.lossy || c.isBounded())
                             orderB.remotePort = pA.description.outputPorts[c.portA].lossyPort;
                         else
                             orderB.remotePort = pA.description.outputPorts[c.portA].losslessPort;
 
+                        orderB.remoteIpc = ipcEndpoint(pA, c.portA, c.lossy || c.isBounded(), pB);
+
                         map[pA].orders.append(orderA);
                         map[pB].orders.append(orderB);
                     }
@@ -1001,6 +1136,15 @@ bool modulight::Application::handleAddConnection(const DynamicRequest &r)
                 return false;
             }
 
+            if (r.queueBound < 0)
+            {
+                cerr << QString("Invalid ADD_CONNECTION request : negative queue bound (%1%2:%3->%4%5:%6)").arg(
+                            r.sourceName).arg(r.sourceInstance).arg(r.sourcePort).arg(r.destinationName).arg(
+                            r.destinationInstance).arg(r.destinationPort).toStdString() << endl;
+
+                return false;
+            }
+
             DynamicOrder orderA, orderB;
             DynamicOrderSequence sequenceA, sequenceB;
             QString xmlA, xmlB;
@@ -1008,20 +1152,40 @@ bool modulight::Application::handleAddConnection(const DynamicRequest &r)
             orderA.type = OrderType::ACCEPT;
             orderA.localPortName = r.sourcePort;
             orderA.remoteAbbrevName = QString("%1%2:%3").arg(r.destinationName).arg(r.destinationInstance).arg(r.destinationPort);
+            orderA.remoteId = inputPortId(b.id, b.description.inputPorts.indexOf(r.destinationPort));
             orderA.lossyConnection = r.lossyConnection;
+            orderA.queueBound = r.lossyConnection ? 0 : r.queueBound;
+            orderA.queuePolicy = r.queuePolicy;
+            orderA.msTimeToLive = qMax(0, r.msTimeToLive);
+            orderA.decimation = qMax(1, r.decimation);
+            orderA.maxFrequency = qMax(0.0, r.maxFrequency);
+
+            // Sampling is done per remote, on the credit based sockets
+            if (!r.lossyConnection && orderA.queueBound == 0 && (orderA.decimation > 1 || orderA.maxFrequency > 0))
+                orderA.queueBound = MasterConnection::SAMPLED_QUEUE_BOUND;
 
             orderB.type = OrderType::CONNECT;
             orderB.localPortName = r.destinationPort;
             orderB.remoteAbbrevName = QString("%1%2:%3").arg(r.sourceName).arg(r.sourceInstance).arg(r.sourcePort);
             orderB.remoteIP = a.description.ip;
             orderB.syncPort = a.description.syncPort;
+            orderB.remoteId = outputPortId(a.id, a.description.outputPorts[r.sourcePort].index);
             orderB.lossyConnection = r.lossyConnection;
+            orderB.queueBound = orderA.queueBound;
+            orderB.msTimeToLive = orderA.msTimeToLive;
 
-            if (r.lossyConnection)
+            bool creditBased = r.lossyConnection || orderB.queueBound > 0;
+
+            if (creditBased)
                 orderB.remotePort = a.description.outputPorts[r.sourcePort].lossyPort;
             else
                 orderB.remotePort = a.description.outputPorts[r.sourcePort].losslessPort;
 
+            orderB.remoteIpc = ipcEndpoint(a, r.sourcePort, creditBased, b);
+            orderB.sharedMemory = orderB.queueBound == 0 && usesSharedMemory(a, r.sourcePort, b);
+            orderA.sharedMemory = orderB.sharedMemory;
+            steeringEndpoint(a, r.sourcePort, b, r.destinationPort, orderB.steeringPort, orderB.steeringIpc);
+
             /*if (r.lossyConnection)
                 cout << "Master is adding a lossy connection : " << a.description.outputPorts[r.sourcePort].lossyPort
                      << " instead of " << a.description.outputPorts[r.sourcePort].losslessPort << endl;
@@ -1056,6 +1220,11 @@ bool modulight::Application::handleAddConnection(const DynamicRequest &r)
             c.portA = r.sourcePort;
             c.portB = r.destinationPort;
             c.lossy = r.lossyConnection;
+            c.queueBound = orderA.queueBound;
+            c.queuePolicy = r.queuePolicy;
+            c.msTimeToLive = orderA.msTimeToLive;
+            c.decimation = orderA.decimation;
+            c.maxFrequency = orderA.maxFrequency;
 
             if (!c.lossy)
                 cout << QString("New connection : %1%2:%3->%4%5:%6").arg(r.sourceName).arg(
@@ -1120,6 +1289,7 @@ bool modulight::Application::handleRemoveConnection(const DynamicRequest &r)
             orderB.remoteAbbrevName = QString("%1%2:%3").arg(r.sourceName).arg(r.sourceInstance).arg(r.sourcePort);
             orderB.remoteIP = a.description.ip;
             orderB.syncPort = a.description.syncPort;
+            orderB.remoteId = outputPortId(a.id, a.description.outputPorts[r.sourcePort].index);
 
             MasterConnection c;
             c.processA = a.id;
@@ -1132,11 +1302,15 @@ bool modulight::Application::handleRemoveConnection(const DynamicRequest &r)
             if (index == -1)
                 throw Exception("Trying to remove an unknown connection");
 
-            if (_currentConnections[index].lossy)
+            bool creditBased = _currentConnections[index].lossy || _currentConnections[index].isBounded();
+
+            if (creditBased)
                 orderB.remotePort = a.description.outputPorts[r.sourcePort].lossyPort;
             else
                 orderB.remotePort = a.description.outputPorts[r.sourcePort].losslessPort;
 
+            orderB.remoteIpc = ipcEndpoint(a, r.sourcePort, creditBased, b);
+
             orderA.lossyConnection = _currentConnections[index].lossy;
             orderB.lossyConnection = _currentConnections[index].lossy;
 
@@ -1213,6 +1387,7 @@ bool modulight::Application::handleAddModule(const DynamicRequest &r)
 
     MPI_Info_create(&info);
     MPI_Info_set(info, hostQBA.data(), hostValueQBA.data());
+    p.host = hostValueQBA;
 
     MPI_Comm_spawn(command.data(), MPI_ARGV_NULL, 1, info, 0, MPI_COMM_WORLD, &p.comm, &errcode);
 
@@ -1225,7 +1400,8 @@ bool modulight::Application::handleAddModule(const DynamicRequest &r)
     recvQString(xmlDescription, p.rank, tag::MODULE_DESCRIPTION, p.comm, MPI_STATUS_IGNORE);
     xml::readModuleDescription(xmlDescription, p.description);
 
-    MPI_Send(&p.instanceNumber, 1, MPI_INT, p.rank, tag::INSTANCE_INFO, p.comm);
+    int instanceInfo[2] = {p.instanceNumber, p.id};
+    MPI_Send(instanceInfo, 2, MPI_INT, p.rank, tag::INSTANCE_INFO, p.comm);
 
     int u = 42;
     MPI_Send(&u, 1, MPI_INT, p.rank, tag::START_ORDER, p.comm);
@@ -1311,13 +1487,16 @@ bool modulight::Application::handleRemoveModule(const DynamicRequest &r, int req
         orderB.remoteAbbrevName = QString("%1%2:%3").arg(pA.description.name).arg(pA.instanceNumber).arg(c.portA);
         orderB.remoteIP = pA.description.ip;
         orderB.syncPort = pA.description.syncPort;
+        orderB.remoteId = outputPortId(pA.id, pA.description.outputPorts[c.portA].index);
         orderB.lossyConnection = c.lossy;
 
-        if (c.lossy)
+        if (c.lossy || c.isBounded())
             orderB.remotePort = pA.description.outputPorts[c.portA].lossyPort;
         else
             orderB.remotePort = pA.description.outputPorts[c.portA].losslessPort;
 
+        orderB.remoteIpc = ipcEndpoint(pA, c.portA, c.lossy || c.isBounded(), pB);
+
 
         map[pA].orders.append(orderA);
         map[pB].orders.append(orderB);
@@ -1430,6 +1609,59 @@ bool modulight::Application::isCurrentlyConnected(int pidA, const QString &portA
     return false;
 }
 
+bool modulight::Application::areColocated(const Process &a, const Process &b) const
+{
+    // Modules report the first non-loopback IPv4 address of their host. The spawn host is checked too,
+    // so that modules reporting the same private address from different hosts are not mistaken for neighbours
+    return !a.description.ip.isEmpty() && a.description.ip == b.description.ip && a.host == b.host;
+}
+
+QString modulight::Application::ipcEndpoint(const Process &source, const QString &sourcePort, bool lossy, const Process &destination) const
+{
+    if (!areColocated(source, destination))
+        return QString();
+
+    ModuleDescription::OutputPort o = source.description.outputPorts.value(sourcePort);
+
+    if (lossy)
+        return o.lossyIpc;
+    else if (!o.sharedMemoryIpc.isEmpty())
+        return o.sharedMemoryIpc;
+    else
+        return o.losslessIpc;
+}
+
+bool modulight::Application::usesSharedMemory(const Process &source, const QString &sourcePort, const Process &destination) const
+{
+    return areColocated(source, destination) && !source.description.outputPorts.value(sourcePort).sharedMemoryIpc.isEmpty();
+}
+
+void modulight::Application::steeringEndpoint(const Process &source, const QString &sourcePort, const Process &destination,
+                                             const QString &destinationPort, quint16 &port, QString &ipc) const
+{
+    ModuleDescription::OutputPort o = source.description.outputPorts.value(sourcePort);
+
+    port = 0;
+    ipc.clear();
+
+    if (o.steeringPort == 0)
+        return;
+
+    // The steering messages are only sent on the lane, an input port without one cannot receive them
+    if (!destination.description.steeringInputPorts.contains(destinationPort))
+    {
+        cerr << "Warning : " << source.description.name.toStdString() << source.instanceNumber << ":" << sourcePort.toStdString()
+             << " has a steering lane but " << destination.description.name.toStdString() << destination.instanceNumber << ":"
+             << destinationPort.toStdString() << " has none, it will not receive steering messages" << endl;
+        return;
+    }
+
+    port = o.steeringPort;
+
+    if (areColocated(source, destination))
+        ipc = o.steeringIpc;
+}
+
 modulight::Process & modulight::Application::processByNameAndInstance(const QString &name, int instance)
 {
     for (int i = 0; i < _processes.size(); ++i)
@@ -7,27 +7,30 @@ using namespace std;
 
 modulight::MessageReader::MessageReader() :
     _data(0),
+    _size(0),
     _loaded(false),
-    _readCursor(0)
+    _readCursor(0),
+    _sourceId(0),
+    _sourceNames(0)
 {
 }
 
-void modulight::MessageReader::load(char *buf, int bufSize, const QString & portName, const QString & source,
-                                    int moduleIteration, int portIteration)
+void modulight::MessageReader::load(const QSharedPointer<zmq::message_t> & message, const QString & portName, quint32 sourceId,
+                                    const QMap<quint32, QString> * sourceNames, int moduleIteration, int portIteration)
 {
     if (!_loaded)
     {
         _loaded = true;
 
-        _data.resize(bufSize);
+        _message = message;
+        _data = (const char *) _message->data();
+        _size = _message->size();
         _readCursor = 0;
         _portName = portName;
-        _source = source;
+        _sourceId = sourceId;
+        _sourceNames = sourceNames;
         _moduleIteration = moduleIteration;
         _portIteration = portIteration;
-
-        if (bufSize > 0)
-            memcpy(_data.data(), buf, bufSize * sizeof(char));
     }
     else
         cerr << "Bad call of MessageReader::load. This method shouldn't be called by the user" << endl;
@@ -39,18 +42,20 @@ void modulight::MessageReader::clear()
     {
         _loaded = false;
 
-        _data.clear();
+        _message.clear();
+        _data = 0;
+        _size = 0;
         _readCursor = 0;
     }
 }
 
 int modulight::MessageReader::readInt()
 {
-    if (_readCursor + (int)sizeof(int) > _data.size())
+    if (_readCursor + (int)sizeof(int) > _size)
         throw Exception("Bad Message::readInt : out of bounds");
 
     int ret;
-    memcpy(&ret, &_data[_readCursor], sizeof(int));
+    memcpy(&ret, _data + _readCursor, sizeof(int));
     _readCursor += sizeof(int);
 
     return ret;
@@ -58,11 +63,11 @@ int modulight::MessageReader::readInt()
 
 float modulight::MessageReader::readFloat()
 {
-    if (_readCursor + (int)sizeof(float) > _data.size())
+    if (_readCursor + (int)sizeof(float) > _size)
         throw Exception("Bad Message::readFloat : out of bounds");
 
     float ret;
-    memcpy(&ret, &_data[_readCursor], sizeof(float));
+    memcpy(&ret, _data + _readCursor, sizeof(float));
     _readCursor += sizeof(float);
 
     return ret;
@@ -70,11 +75,11 @@ float modulight::MessageReader::readFloat()
 
 double modulight::MessageReader::readDouble()
 {
-    if (_readCursor + (int)sizeof(double) > _data.size())
+    if (_readCursor + (int)sizeof(double) > _size)
         throw Exception("Bad Message::readDouble : out of bounds");
 
     double ret;
-    memcpy(&ret, &_data[_readCursor], sizeof(double));
+    memcpy(&ret, _data + _readCursor, sizeof(double));
     _readCursor += sizeof(double);
 
     return ret;
@@ -82,18 +87,18 @@ double modulight::MessageReader::readDouble()
 
 std::string modulight::MessageReader::readStdString()
 {
-    if (_readCursor + (int)sizeof(unsigned int) > _data.size())
+    if (_readCursor + (int)sizeof(unsigned int) > _size)
         throw Exception("Bad Message::readString : out of bounds");
 
     unsigned int stringSize;
 
-    memcpy(&stringSize, &_data[_readCursor], sizeof(unsigned int));
+    memcpy(&stringSize, _data + _readCursor, sizeof(unsigned int));
     _readCursor += sizeof(unsigned int);
 
-    if ((int)(_readCursor + stringSize * sizeof(char)) > _data.size())
+    if ((int)(_readCursor + stringSize * sizeof(char)) > _size)
         throw Exception("Bad Message::readString : critical internal error in the written string");
 
-    std::string ret(&_data[_readCursor], stringSize);
+    std::string ret(_data + _readCursor, stringSize);
     _readCursor += stringSize*sizeof(char);
 
     return ret;
@@ -101,24 +106,32 @@ std::string modulight::MessageReader::readStdString()
 
 QString modulight::MessageReader::readQString()
 {
-    if (_readCursor + (int)sizeof(unsigned int) > _data.size())
+    if (_readCursor + (int)sizeof(unsigned int) > _size)
         throw Exception("Bad Message::readString : out of bounds");
 
     QString ret;
     unsigned int stringSize;
 
-    memcpy(&stringSize, &_data[_readCursor], sizeof(unsigned int));
+    memcpy(&stringSize, _data + _readCursor, sizeof(unsigned int));
     _readCursor += sizeof(unsigned int);
 
-    if ((int)(_readCursor + stringSize*sizeof(char)) > _data.size())
+    if ((int)(_readCursor + stringSize*sizeof(char)) > _size)
         throw Exception("Bad Message::readString : critical internal error in the written string");
 
-    ret = QString::fromUtf8(&_data[_readCursor], stringSize);
+    ret = QString::fromUtf8(_data + _readCursor, stringSize);
     _readCursor += stringSize*sizeof(char);
 
     return ret;
 }
 
+QString modulight::MessageReader::sourceName() const
+{
+    if (_sourceNames == 0)
+        return QString();
+
+    return _sourceNames->value(_sourceId);
+}
+
 int modulight::MessageReader::cursorPosition() const
 {
     return _readCursor;
@@ -126,16 +139,16 @@ int modulight::MessageReader::cursorPosition() const
 
 void modulight::MessageReader::setCursorPosition(int cursorPosition)
 {
-    Q_ASSERT_X(cursorPosition >= 0 && cursorPosition < _data.size(), "MessageReader::setCursorPosition", "Invalid cursor position");
+    Q_ASSERT_X(cursorPosition >= 0 && cursorPosition < _size, "MessageReader::setCursorPosition", "Invalid cursor position");
     _readCursor = cursorPosition;
 }
 
 const char *modulight::MessageReader::data() const
 {
-    return _data.data();
+    return _data;
 }
 
 int modulight::MessageReader::size() const
 {
-     return _data.size();
+     return _size;
 }
@@ -7,27 +7,134 @@
 #include <QStringList>
 #include <QDebug>
 #include <QTime>
+#include <QDateTime>
 #include <QNetworkInterface>
 #include <QHostAddress>
+#include <QDir>
 
 #include <modulight/common/mpiutils.hpp>
 #include <modulight/common/xml.hpp>
 #include <modulight/common/tag.hpp>
 #include <modulight/common/modulightexception.hpp>
+#include <modulight/common/portid.hpp>
 #include <modulight/module/stamp.hpp>
+#include <modulight/module/sharedmemoryring.hpp>
 
 using namespace std;
 using namespace modulight::mpi_util;
 using namespace modulight;
 using namespace zmq;
 
+// Called by ZeroMQ once a zero-copy message is sent, to release its reference on the MessageWriter (or batch) buffer
+static void releaseWriterBuffer(void *, void * hint)
+{
+    delete static_cast<QVector<char> *>(hint);
+}
+
+// Called by ZeroMQ once a message read from a batch is destroyed, to release its reference on the whole batch
+static void releaseBatchEntry(void *, void * hint)
+{
+    delete static_cast<QSharedPointer<zmq::message_t> *>(hint);
+}
+
+// Kept alive by a message which points into a shared memory ring slot, the slot is released once the message is destroyed
+struct SharedMemorySlotHandle
+{
+    QSharedPointer<SharedMemoryRing> ring;
+    int slot;
+    int reader;
+};
+
+static void releaseSharedMemorySlot(void *, void * hint)
+{
+    SharedMemorySlotHandle * handle = static_cast<SharedMemorySlotHandle *>(hint);
+
+    handle->ring->releaseSlot(handle->slot, handle->reader);
+    delete handle;
+}
+
+// Binds the socket on an ipc:// endpoint unique to this process, returns an empty string if it is impossible (no Unix domain sockets)
+static QString bindIpc(zmq::socket_t & socket, int portIndex, const char * kind)
+{
+    QString endpoint = QString("ipc://%1/modulight-%2-%3-%4").arg(QDir::tempPath()).arg(getpid()).arg(portIndex).arg(kind);
+
+    try
+    {
+        socket.bind(endpoint.toUtf8().data());
+    }
+    catch(zmq::error_t &)
+    {
+        return QString();
+    }
+
+    return endpoint;
+}
+
+// Converts the msToSleep argument of the wait methods to µs (-1 => 1 µs)
+static int sleepDuration(int msToSleep)
+{
+    if (msToSleep > 0)
+        return msToSleep * 1000;
+    else if (msToSleep < 0)
+        return 1;
+
+    return 0;
+}
+
+static zmq_pollitem_t pollItem(zmq::socket_t & socket)
+{
+    zmq_pollitem_t item;
+
+    item.socket = socket;
+    item.fd = 0;
+    item.events = ZMQ_POLLIN;
+    item.revents = 0;
+
+    return item;
+}
+
+// 0 => messages never expire
+static bool isExpired(qint64 sendTime, int msTimeToLive)
+{
+    return msTimeToLive > 0 && QDateTime::currentMSecsSinceEpoch() - sendTime > msTimeToLive;
+}
+
+// Sent by the consumer once it knows the remote : a lossy connection allows one message, a bounded one queueBound messages
+static void sendFirstCredit(zmq::socket_t & dealer, int queueBound)
+{
+    if (queueBound > 0)
+    {
+        qint32 credits = queueBound;
+        dealer.send(&credits, sizeof(qint32), ZMQ_DONTWAIT);
+    }
+    else
+        dealer.send(0, 0, ZMQ_DONTWAIT);
+}
+
+// The master gives the ipc:// endpoint of the remote port if it runs on the same host, TCP is used otherwise
+static QByteArray remoteEndpoint(const QString & ip, quint16 port, const QString & ipc)
+{
+    if (!ipc.isEmpty())
+        return ipc.toUtf8();
+
+    return QString("tcp://%1:%2").arg(ip).arg(port).toUtf8();
+}
+
 modulight::Module::Module(const QString &moduleName, int argc, char **argv) :
     _name(moduleName),
     _instanceNumber(-1),
+    _processId(-1),
     _launchWithoutEnvironment(false),
     _state(ModuleState::UNINITIALIZED),
     _context(1),
-    _syncRep(_context, ZMQ_REP)
+    _syncRep(_context, ZMQ_REP),
+    _waitMode(WaitMode::BLOCKING),
+    _msDynamicOrderPeriod(10),
+    _sendMode(SendMode::COPY),
+    _progressThread(0),
+    _progressMutex(QMutex::Recursive),
+    _sendWaitDepth(0),
+    _finalizeDeferred(false)
 {
     static bool first = true;
 
@@ -40,30 +147,9 @@ modulight::Module::Module(const QString &moduleName, int argc, char **argv) :
     {
         first = false;
 
-        MPI_Init(&argc, &argv);
-
-        /*int thread_support;
-        MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_support);
-
-        if (thread_support != MPI_THREAD_FUNNELED)
-        {
-            switch(thread_support)
-            {
-            case MPI_THREAD_SINGLE:
-                cout << "Information : module " << _name.toStdString() << " is launched without thread support" << endl;
-                break;
-            case MPI_THREAD_SERIALIZED:
-                cout << "Information : module " << _name.toStdString() << " is launched in Serialized thread support" << endl;
-                break;
-            case MPI_THREAD_MULTIPLE:
-                cout << "Information : module " << _name.toStdString() << " is launched in Multiple thread support" << endl;
-                break;
-            default:
-                error() << "Invalid thread support value" << endl;
-                throw Exception("Invalid thread support value");
-            }
-        }
-*/
+        // The progress thread and the user thread may both call MPI, never at the same time (see startProgressThread)
+        int threadSupport;
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &threadSupport);
 
         MPI_Comm_get_parent(&_parent);
 
@@ -131,26 +217,43 @@ modulight::Module::Module(const QString &moduleName, int argc, char **argv) :
 
 modulight::Module::~Module()
 {
-    QMapIterator<QString, InputPort> itIn(_inputPorts);
-    while (itIn.hasNext())
+    stopProgressThread();
+
+    // Finalizing sends the posted messages, the pending batches and the messages held back by rate limits,
+    // so it must be done while the sockets still exist
+    if (_state != ModuleState::FINALIZED)
+        finalize();
+
+    for (int i = 0; i < _inputPorts.size(); ++i)
     {
-        itIn.next();
+        delete _inputPorts[i].sub;
+        delete _inputPorts[i].steeringSub;
 
-        delete itIn.value().sub;
-        delete itIn.value().req;
+        for (int j = 0; j < _inputPorts[i].lossyChannels.size(); ++j)
+            delete _inputPorts[i].lossyChannels[j].dealer;
     }
 
-    QMapIterator<QString, OutputPort> itOut(_outputPorts);
-    while (itOut.hasNext())
+    for (int i = 0; i < _outputPorts.size(); ++i)
     {
-        itOut.next();
+        // A thread may have posted a message after the last drain of finalize(), between its state check and its push
+        int dropped = 0;
 
-        delete itOut.value().pub;
-        delete itOut.value().rep;
-    }
+        for (SendQueue::Message * m = _outputPorts[i].sendQueue->takeAll(); m; ++dropped)
+        {
+            SendQueue::Message * next = m->next;
+            delete m;
+            m = next;
+        }
 
-    if (_state != ModuleState::FINALIZED)
-        finalize();
+        if (dropped > 0)
+            error() << dropped << " message(s) posted on " << _outputPorts[i].name.toStdString()
+                    << " after the module was finalized had been dropped" << endl;
+
+        delete _outputPorts[i].pub;
+        delete _outputPorts[i].router;
+        delete _outputPorts[i].shmPub;
+        delete _outputPorts[i].steeringPub;
+    }
 
     int isMPIFinalized = 0;
     MPI_Finalized(&isMPIFinalized);
@@ -160,6 +263,8 @@ modulight::Module::~Module()
 
     _inputPorts.clear();
     _outputPorts.clear();
+    _inputPortIndexes.clear();
+    _outputPortIndexes.clear();
 }
 
 bool modulight::Module::initialize()
@@ -186,6 +291,7 @@ bool modulight::Module::initialize()
         if (receiveOrders())
         {
             _state = ModuleState::RUNNING;
+            applyRateLimitArguments();
             return true;
         }
         else
@@ -198,11 +304,23 @@ bool modulight::Module::initialize()
 
 void modulight::Module::finalize()
 {
+    stopProgressThread();
+
+    QMutexLocker locker(progressLock());
+
     if (_state == ModuleState::RUNNING)
     {
         int i = 42;
         MPI_Request request;
 
+        drainSendQueues();
+
+        for (int p = 0; p < _outputPorts.size(); ++p)
+        {
+            flushBatch(_outputPorts[p]);
+            flushPacedMessage(_outputPorts[p], true);
+        }
+
         MPI_Isend(&i, 1, MPI_INT, 0, tag::MODULE_FINISHED, _parent, &request);
 
         bool canExit = false;
@@ -225,8 +343,13 @@ void modulight::Module::finalize()
     else if (_state == ModuleState::UNINITIALIZED)
         display() << "Going straight from Uninitialized to Finalized (have you forgot to call Module::initialize ?)" << endl;
 
+    ModuleState::ModuleState previousState = _state;
     _state = ModuleState::FINALIZED;
 
+    // Messages posted by other threads while finalizing are sent all the same, postMessage() refuses the next ones
+    if (previousState == ModuleState::RUNNING)
+        drainSendQueues();
+
     //display() << "Finalized" << endl;
 }
 
@@ -239,6 +362,8 @@ bool modulight::Module::getNetwork(Network &network)
         return false;
     }
 
+    QMutexLocker locker(progressLock());
+
     int i;
     MPI_Ssend(&i, 0, MPI_INT, 0, tag::NETWORK_REQUEST, _parent);
 
@@ -254,7 +379,8 @@ bool modulight::Module::getNetwork(Network &network)
 
 bool modulight::Module::addConnection(const QString & sourceName, int sourceInstance, const QString & sourcePort,
     const QString & destinationName, int destinationInstance, const QString & destinationPort,
-    bool lossyConnection)
+    bool lossyConnection, int queueBound, QueuePolicy::QueuePolicy queuePolicy, int msTimeToLive,
+    int decimation, double maxFrequency)
 {
     if (_state != ModuleState::RUNNING)
     {
@@ -263,9 +389,32 @@ bool modulight::Module::addConnection(const QString & sourceName, int sourceInst
         return false;
     }
 
+    if (queueBound < 0)
+    {
+        error() << "Invalid addConnection call : the queue bound must not be negative" << endl;
+        return false;
+    }
+
+    if (msTimeToLive < 0)
+    {
+        error() << "Invalid addConnection call : the time to live must not be negative" << endl;
+        return false;
+    }
+
+    if (decimation < 1 || maxFrequency < 0)
+    {
+        error() << "Invalid addConnection call : the decimation must be positive and the maximum frequency must not be negative" << endl;
+        return false;
+    }
+
     DynamicRequest r;
     r.type = RequestType::ADD_CONNECTION;
     r.lossyConnection = lossyConnection;
+    r.queueBound = queueBound;
+    r.queuePolicy = queuePolicy;
+    r.msTimeToLive = msTimeToLive;
+    r.decimation = decimation;
+    r.maxFrequency = maxFrequency;
 
     r.sourceName = sourceName;
     r.sourceInstance = sourceInstance;
@@ -307,12 +456,12 @@ bool modulight::Module::applyDynamicRequestSequence(modulight::DynamicRequestSeq
 
     xml::writeDynamicRequests(xmlString, sequence);
 
-    sendQString(xmlString, 0, tag::DYNAMIC_REQUEST, _parent);
-
-    int i;
-    MPI_Recv(&i, 1, MPI_INT, 0, tag::REQUEST_RESULT, _parent, MPI_STATUS_IGNORE);
+    {
+        QMutexLocker locker(progressLock());
+        sendQString(xmlString, 0, tag::DYNAMIC_REQUEST, _parent);
+    }
 
-    return i != 0;
+    return receiveRequestResult() != 0;
 }
 
 bool modulight::Module::spawnProcess(const QString &command, const ArgumentWriter &writer, const QString & hostname)
@@ -368,6 +517,14 @@ ostream & modulight::Module::error() const
 
 bool modulight::Module::checkDynamicOrders()
 {
+    // The destroy order received during a send is applied at the first check done outside of a send
+    if (_finalizeDeferred && _sendWaitDepth == 0)
+    {
+        _finalizeDeferred = false;
+        finalize();
+        return true;
+    }
+
     //QTime time;
     //time.start();
 
@@ -427,53 +584,84 @@ void modulight::Module::handleDynamicOrders()
     MPI_Send(&i, 0, MPI_INT, 0, tag::ORDER_DONE, _parent);
 
     // To avoid a deadlock between the destroyed process and the master
-    // ORDER_DONE must be sent before MODULE_FINISH (which is done by finalize)
+    // ORDER_DONE must be sent before MODULE_FINISH (which is done by finalize).
+    // A send waiting for its destinations would go on with finalized ports, finalizing is then deferred
     if (destroyOrderReceived)
-        finalize();
+    {
+        if (_sendWaitDepth > 0)
+            _finalizeDeferred = true;
+        else
+            finalize();
+    }
 }
 
 void modulight::Module::handleDynamicAccept(const DynamicOrder &o)
 {
+    int portIndex = orderedPortIndex(_outputPortIndexes, o.localPortName);
+
+    // The remote is answered anyway, so that it does not wait forever
+    if (portIndex == -1)
+    {
+        answerSync();
+        return;
+    }
+
+    OutputPort & port = _outputPorts[portIndex];
+
     if (o.lossyConnection)
-        _outputPorts[o.localPortName].lossyRemotes[o.remoteAbbrevName] = true;
+        port.addLossyRemote(o.remoteAbbrevName, o.remoteId, o.sharedMemory, o.msTimeToLive, Sampler(o.decimation, o.maxFrequency));
+    else if (o.queueBound > 0)
+        port.addBoundedRemote(o.remoteAbbrevName, o.remoteId, o.queueBound, o.queuePolicy, o.msTimeToLive,
+                              Sampler(o.decimation, o.maxFrequency));
     else
-        _outputPorts[o.localPortName].losslessRemotes.append(o.remoteAbbrevName);
+        port.losslessRemotes.append(o.remoteAbbrevName);
 
-    message_t msg;
-    _syncRep.recv(&msg);
-    _syncRep.send(msg);
+    if (o.sharedMemory)
+        addSharedMemoryReader(port, o.remoteAbbrevName, o.remoteId, !o.lossyConnection);
+
+    answerSync();
 }
 
 void modulight::Module::handleDynamicConnect(const DynamicOrder &o)
 {
-    QString remote = QString("tcp://%1:%2").arg(o.remoteIP).arg(o.remotePort);
-    QByteArray qbaRemote = remote.toUtf8();
+    QByteArray qbaRemote = remoteEndpoint(o.remoteIP, o.remotePort, o.remoteIpc);
 
     /*display() << "Connecting " << o.localPortName.toStdString() << " to "
               << qbaRemote.data() << endl;*/
 
-    if (o.lossyConnection)
+    int portIndex = orderedPortIndex(_inputPortIndexes, o.localPortName);
+
+    // The remote is answered anyway, so that it does not wait forever
+    if (portIndex == -1)
     {
-        _inputPorts[o.localPortName].req->connect(qbaRemote.data());
-        _inputPorts[o.localPortName].lossyRemotes.append(o.remoteAbbrevName);
+        requestSync(o.remoteIP, o.syncPort);
+        return;
     }
+
+    InputPort & port = _inputPorts[portIndex];
+    _sourceNames[o.remoteId] = o.remoteAbbrevName;
+
+    if (o.lossyConnection || o.queueBound > 0)
+        addLossyChannel(port, o.remoteAbbrevName, qbaRemote);
     else
     {
-        _inputPorts[o.localPortName].sub->connect(qbaRemote.data());
-        _inputPorts[o.localPortName].losslessRemotes.append(o.remoteAbbrevName);
+        if (o.sharedMemory)
+            subscribeToSharedMemory(port);
+
+        port.sub->connect(qbaRemote.data());
+        port.losslessRemotes.append(o.remoteAbbrevName);
     }
 
-    socket_t req(_context, ZMQ_REQ);
-    int hwm = 0;
-    req.setsockopt(ZMQ_RCVHWM, &hwm, sizeof(int));
-    req.setsockopt(ZMQ_SNDHWM, &hwm, sizeof(int));
+    connectSteeringLane(port, o.remoteAbbrevName, o.remoteIP, o.steeringPort, o.steeringIpc);
 
-    QByteArray qbaSync = QString("tcp://%1:%2").arg(o.remoteIP).arg(o.syncPort).toUtf8();
-    req.connect(qbaSync.data());
+    if (o.msTimeToLive > 0)
+        port.timeToLive[o.remoteId] = o.msTimeToLive;
 
-    message_t msg;
-    req.send(msg);
-    req.recv(&msg);
+    requestSync(o.remoteIP, o.syncPort);
+
+    // The remote knows this port now, it can receive its first credit
+    if (o.lossyConnection || o.queueBound > 0)
+        sendFirstCredit(*port.lossyChannels.last().dealer, o.queueBound);
 }
 
 void modulight::Module::handleDynamicOutputDisconnect(const DynamicOrder &o)
@@ -481,41 +669,102 @@ void modulight::Module::handleDynamicOutputDisconnect(const DynamicOrder &o)
     /*display() << "Disconnecting " << o.localPortName.toStdString() << " to "
               << o.remoteAbbrevName.toStdString() << endl;*/
 
+    int portIndex = orderedPortIndex(_outputPortIndexes, o.localPortName);
+
+    if (portIndex == -1)
+    {
+        answerSync();
+        return;
+    }
+
+    OutputPort & port = _outputPorts[portIndex];
+
     if (o.lossyConnection)
-        _outputPorts[o.localPortName].lossyRemotes.remove(o.remoteAbbrevName);
+    {
+        int index = port.lossyRemoteIndex(o.remoteAbbrevName);
+
+        if (index != -1)
+            port.lossyRemotes.remove(index);
+    }
     else
-        _outputPorts[o.localPortName].losslessRemotes.removeAll(o.remoteAbbrevName);
+    {
+        int index = port.boundedRemoteIndex(o.remoteAbbrevName);
 
-    message_t msg;
-    _syncRep.recv(&msg);
-    _syncRep.send(msg);
+        // Messages still queued for the remote are lost with the connection
+        if (index != -1)
+            port.boundedRemotes.remove(index);
+
+        port.losslessRemotes.removeAll(o.remoteAbbrevName);
+    }
+
+    removeSharedMemoryReader(port, o.remoteAbbrevName);
+
+    answerSync();
 }
 
 void modulight::Module::handleDynamicInputDisconnect(const DynamicOrder &o)
 {
-    QString remote = QString("tcp://%1:%2").arg(o.remoteIP).arg(o.remotePort);
-    QByteArray qbaRemote = remote.toUtf8();
+    QByteArray qbaRemote = remoteEndpoint(o.remoteIP, o.remotePort, o.remoteIpc);
 
     /*display() << "Disconnecting " << o.localPortName.toStdString() << " from "
               << o.remoteAbbrevName.toStdString() << endl;*/
 
-    if (o.lossyConnection)
+    int portIndex = orderedPortIndex(_inputPortIndexes, o.localPortName);
+
+    if (portIndex == -1)
     {
-        zmq_disconnect(*_inputPorts[o.localPortName].req, qbaRemote.data());
-        _inputPorts[o.localPortName].lossyRemotes.removeAll(o.remoteAbbrevName);
+        requestSync(o.remoteIP, o.syncPort);
+        return;
     }
+
+    InputPort & port = _inputPorts[portIndex];
+
+    // Bounded connections use lossy channels too
+    if (o.lossyConnection || port.lossyChannelIndex(o.remoteAbbrevName) != -1)
+        removeLossyChannel(port, o.remoteAbbrevName);
     else
     {
-        zmq_disconnect(*_inputPorts[o.localPortName].sub, qbaRemote.data());
-        _inputPorts[o.localPortName].losslessRemotes.removeAll(o.remoteAbbrevName);
+        zmq_disconnect(*port.sub, qbaRemote.data());
+        port.losslessRemotes.removeAll(o.remoteAbbrevName);
+    }
+
+    disconnectSteeringLane(port, o.remoteAbbrevName);
+    port.timeToLive.remove(o.remoteId);
+
+    // Messages which have not been read yet keep the ring mapped
+    port.sharedMemorySources.remove(o.remoteId);
+
+    requestSync(o.remoteIP, o.syncPort);
+}
+
+int modulight::Module::orderedPortIndex(const QMap<QString, int> &portIndexes, const QString &portName)
+{
+    QMap<QString, int>::const_iterator it = portIndexes.constFind(portName);
+
+    if (it == portIndexes.constEnd())
+    {
+        error() << "Critical coherence error within modulight : connection order received on unknown port " << portName.toStdString() << endl;
+        return -1;
     }
 
+    return it.value();
+}
+
+void modulight::Module::answerSync()
+{
+    message_t msg;
+    _syncRep.recv(&msg);
+    _syncRep.send(msg);
+}
+
+void modulight::Module::requestSync(const QString &remoteIP, quint16 syncPort)
+{
     socket_t req(_context, ZMQ_REQ);
     int hwm = 0;
     req.setsockopt(ZMQ_RCVHWM, &hwm, sizeof(int));
     req.setsockopt(ZMQ_SNDHWM, &hwm, sizeof(int));
 
-    QByteArray qbaSync = QString("tcp://%1:%2").arg(o.remoteIP).arg(o.syncPort).toUtf8();
+    QByteArray qbaSync = QString("tcp://%1:%2").arg(remoteIP).arg(syncPort).toUtf8();
     req.connect(qbaSync.data());
 
     message_t msg;
@@ -543,12 +792,108 @@ bool modulight::Module::sendAndReceiveRequest(const DynamicRequest &r)
 
     xml::writeDynamicRequests(xmlString, sequence);
 
-    sendQString(xmlString, 0, tag::DYNAMIC_REQUEST, _parent);
+    {
+        QMutexLocker locker(progressLock());
+        sendQString(xmlString, 0, tag::DYNAMIC_REQUEST, _parent);
+    }
+
+    return receiveRequestResult() != 0;
+}
 
+int modulight::Module::receiveRequestResult()
+{
     int i;
-    MPI_Recv(&i, 1, MPI_INT, 0, tag::REQUEST_RESULT, _parent, MPI_STATUS_IGNORE);
 
-    return i != 0;
+    if (!_progressThread)
+    {
+        MPI_Recv(&i, 1, MPI_INT, 0, tag::REQUEST_RESULT, _parent, MPI_STATUS_IGNORE);
+        return i;
+    }
+
+    // The lock is released between two probes, so that the progress thread can apply the orders sent while the master handles the request
+    while (true)
+    {
+        QMutexLocker locker(progressLock());
+
+        int resultReceived;
+        MPI_Iprobe(0, tag::REQUEST_RESULT, _parent, &resultReceived, MPI_STATUS_IGNORE);
+
+        if (resultReceived)
+        {
+            MPI_Recv(&i, 1, MPI_INT, 0, tag::REQUEST_RESULT, _parent, MPI_STATUS_IGNORE);
+            return i;
+        }
+
+        locker.unlock();
+        usleep(_msDynamicOrderPeriod * 1000);
+    }
+}
+
+bool modulight::Module::startProgressThread(int msPeriod)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid startProgressThread call : the process is not running" << endl;
+        return false;
+    }
+
+    if (_progressThread)
+    {
+        error() << "Invalid startProgressThread call : the progress thread is already running" << endl;
+        return false;
+    }
+
+    if (msPeriod <= 0)
+    {
+        error() << "Invalid startProgressThread call : the period must be positive" << endl;
+        return false;
+    }
+
+    int threadSupport;
+    MPI_Query_thread(&threadSupport);
+
+    if (threadSupport < MPI_THREAD_SERIALIZED)
+    {
+        error() << "Invalid startProgressThread call : MPI does not support MPI_THREAD_SERIALIZED" << endl;
+        return false;
+    }
+
+    _progressThread = new ProgressThread(this, msPeriod);
+    _progressThread->start();
+
+    return true;
+}
+
+void modulight::Module::stopProgressThread()
+{
+    if (!_progressThread)
+        return;
+
+    _progressThread->stop();
+
+    // The progress thread finalizes the module itself when it receives a destroy order, it is waited for by the user thread later
+    if (QThread::currentThread() == _progressThread)
+        return;
+
+    // The thread gives up waiting for the progress lock once stopped, so it can be joined even if this thread holds the lock
+    _progressThread->wait();
+
+    delete _progressThread;
+    _progressThread = 0;
+}
+
+void modulight::Module::progress(int msLockTimeout)
+{
+    // The lock is not waited for indefinitely : a destroy order handled by the user thread within a locked call (a wait() for instance)
+    // stops and joins this thread while the lock is held
+    if (!_progressMutex.tryLock(msLockTimeout))
+        return;
+
+    if (_state == ModuleState::RUNNING)
+        serviceOnce();
+
+    _progressMutex.unlock();
 }
 
 const modulight::ArgumentReader & modulight::Module::arguments() const
@@ -556,66 +901,83 @@ const modulight::ArgumentReader & modulight::Module::arguments() const
     return _arguments;
 }
 
-void modulight::Module::addInputPort(const QString &name)
+modulight::PortHandle modulight::Module::addInputPort(const QString &name, int flags)
 {
     if (_state == ModuleState::UNINITIALIZED)
     {
         if (_launchWithoutEnvironment)
-            return;
+            return PortHandle();
 
-        if (_inputPorts.contains(name))
+        if (_inputPortIndexes.contains(name))
         {
             error() << "Invalid addInputPort call : the input port \"" << name.toStdString() << "\" already exists" << endl;
-            return;
+            return PortHandle();
         }
-        else if (_outputPorts.contains(name))
+        else if (_outputPortIndexes.contains(name))
         {
             error() << "Invalid addInputPort call : the port \"" << name.toStdString() << "\" already exists as an output one";
-            return;
+            return PortHandle();
         }
 
         InputPort ip;
         int hwm0 = 0;
 
+        ip.name = name;
+
         ip.sub = new zmq::socket_t(_context, ZMQ_SUB);
         ip.sub->setsockopt(ZMQ_RCVHWM, &hwm0, sizeof(int));
         ip.sub->setsockopt(ZMQ_SUBSCRIBE, "", 0);
 
-        ip.req = new zmq::socket_t(_context, ZMQ_REQ);
+        if (flags & PortFlag::STEERING_LANE)
+        {
+            ip.steeringSub = new zmq::socket_t(_context, ZMQ_SUB);
+            ip.steeringSub->setsockopt(ZMQ_RCVHWM, &hwm0, sizeof(int));
+            ip.steeringSub->setsockopt(ZMQ_SUBSCRIBE, "", 0);
+        }
+
+        _inputPortIndexes[name] = _inputPorts.size();
+        _inputPorts.append(ip);
 
-        _inputPorts[name] = ip;
+        return PortHandle(_inputPorts.size() - 1, true);
     }
     else
         error() << "Invalid addInputPort call : the process has already been initialized" << endl;
+
+    return PortHandle();
 }
 
-void modulight::Module::addOutputPort(const QString &name)
+modulight::PortHandle modulight::Module::addOutputPort(const QString &name, int flags)
 {
     if (_state == ModuleState::UNINITIALIZED)
     {
         if (_launchWithoutEnvironment)
-            return;
+            return PortHandle();
 
-        if (_outputPorts.contains(name))
+        if (_outputPortIndexes.contains(name))
         {
             error() << "Invalid addOutputPort call : the output port \"" << name.toStdString() << "\" already exists" << endl;
-            return;
+            return PortHandle();
         }
-        else if (_inputPorts.contains(name))
+        else if (_inputPortIndexes.contains(name))
         {
             error() << "Invalid addOutputPort call : the port \"" << name.toStdString() << "\" already exists as an input one";
-            return;
+            return PortHandle();
         }
 
         OutputPort op;
         int hwm0 = 0;
 
+        op.name = name;
+
         op.pub = new zmq::socket_t(_context, ZMQ_PUB);
         op.pub->setsockopt(ZMQ_SNDHWM, &hwm0, sizeof(int));
         op.pub->bind("tcp://*:0");
 
-        op.rep = new zmq::socket_t(_context, ZMQ_REP);
-        op.rep->bind("tcp://*:0");
+        // Pushing to a remote which is not connected anymore must fail instead of silently dropping the message
+        int mandatory = 1;
+        op.router = new zmq::socket_t(_context, ZMQ_ROUTER);
+        op.router->setsockopt(ZMQ_ROUTER_MANDATORY, &mandatory, sizeof(int));
+        op.router->bind("tcp://*:0");
 
         QRegExp regex("tcp://.*:(\\d{1,5})");
         size_t bufSize = 100;
@@ -626,70 +988,170 @@ void modulight::Module::addOutputPort(const QString &name)
             throw modulight::Exception(QString("Regex failed in parsing bound port in \"%1\"").arg(QString(buf)));
         op.pubPort = regex.cap(1).toInt();
 
-        op.rep->getsockopt(ZMQ_LAST_ENDPOINT, &buf, &bufSize);
+        bufSize = 100;
+        op.router->getsockopt(ZMQ_LAST_ENDPOINT, &buf, &bufSize);
         if (!regex.exactMatch(QString(buf)))
             throw modulight::Exception(QString("Regex failed in parsing bound port in \"%1\"").arg(QString(buf)));
-        op.repPort = regex.cap(1).toInt();
+        op.routerPort = regex.cap(1).toInt();
+
+        // Modules running on the same host are connected through Unix domain sockets, the TCP endpoints remain for the others
+        op.pubIpc = bindIpc(*op.pub, _outputPorts.size(), "pub");
+        op.routerIpc = bindIpc(*op.router, _outputPorts.size(), "router");
+
+        // Co-located lossless remotes subscribe here, large messages are sent to them as shared memory descriptors
+        op.shmPub = new zmq::socket_t(_context, ZMQ_XPUB);
+        op.shmPub->setsockopt(ZMQ_SNDHWM, &hwm0, sizeof(int));
+        op.shmPubIpc = bindIpc(*op.shmPub, _outputPorts.size(), "shm");
+
+        if (op.shmPubIpc.isEmpty())
+        {
+            delete op.shmPub;
+            op.shmPub = 0;
+        }
+
+        // Small urgent messages get their own socket, so that they never queue behind the bulk data
+        if (flags & PortFlag::STEERING_LANE)
+        {
+            op.steeringPub = new zmq::socket_t(_context, ZMQ_PUB);
+            op.steeringPub->setsockopt(ZMQ_SNDHWM, &hwm0, sizeof(int));
+            op.steeringPub->bind("tcp://*:0");
+
+            bufSize = 100;
+            op.steeringPub->getsockopt(ZMQ_LAST_ENDPOINT, &buf, &bufSize);
+            if (!regex.exactMatch(QString(buf)))
+                throw modulight::Exception(QString("Regex failed in parsing bound port in \"%1\"").arg(QString(buf)));
+            op.steeringPort = regex.cap(1).toInt();
+
+            op.steeringIpc = bindIpc(*op.steeringPub, _outputPorts.size(), "steer");
+        }
+
+        _outputPortIndexes[name] = _outputPorts.size();
+        _outputPorts.append(op);
 
-        _outputPorts[name] = op;
+        return PortHandle(_outputPorts.size() - 1, false);
     }
     else
         error() << "Invalid addOutputPort call : the process had already been initialized" << endl;
+
+    return PortHandle();
 }
 
-bool modulight::Module::readMessage(const QString &iport, MessageReader &reader)
+modulight::PortHandle modulight::Module::inputPort(const QString &name) const
+{
+    QMap<QString, int>::const_iterator it = _inputPortIndexes.constFind(name);
+
+    if (it == _inputPortIndexes.constEnd())
+        return PortHandle();
+
+    return PortHandle(it.value(), true);
+}
+
+modulight::PortHandle modulight::Module::outputPort(const QString &name) const
+{
+    QMap<QString, int>::const_iterator it = _outputPortIndexes.constFind(name);
+
+    if (it == _outputPortIndexes.constEnd())
+        return PortHandle();
+
+    return PortHandle(it.value(), false);
+}
+
+bool modulight::Module::resolveInputPort(const QString &name, const char *method, PortHandle &port)
 {
     if (_state != ModuleState::RUNNING)
     {
         if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
-            error() << "Invalid readMessage call : the process is not running" << endl;
-
+            error() << "Invalid " << method << " call : the process is not running" << endl;
         return false;
     }
 
-    if (!_inputPorts.contains(iport))
+    port = inputPort(name);
+
+    if (!port.isValid())
     {
-        error() << "Invalid readMessage call, no such input port (" << iport.toStdString() << ')' << endl;
+        error() << "Invalid " << method << " call, no such input port (" << name.toStdString() << ')' << endl;
         return false;
     }
 
-    message_t msg;
-    QString source;
-    int moduleIteration;
-    int portIteration;
-    bool isReal;
+    return true;
+}
 
-    if (_inputPorts[iport].messageAvailableOnLossy)
+bool modulight::Module::resolveOutputPort(const QString &name, const char *method, PortHandle &port)
+{
+    if (_state != ModuleState::RUNNING)
     {
-        try
-        {
-            _inputPorts[iport].req->recv(&msg);
-            Stamp::extractUsefulInformationFromData((char*)msg.data(), moduleIteration, portIteration, isReal, source);
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid " << method << " call : the process is not running" << endl;
+        return false;
+    }
 
-            _inputPorts[iport].req->recv(&msg);
-            _inputPorts[iport].messageAvailableOnLossy = false;
-        }
-        catch(zmq::error_t &)
-        {
-            display() << "Exception caught in readMessage : bad recv call (bad REQ state)" << endl;
-            return false;
-        }
+    port = outputPort(name);
+
+    if (!port.isValid())
+    {
+        error() << "Invalid " << method << " call, no such output port (" << name.toStdString() << ')' << endl;
+        return false;
     }
-    else if (_inputPorts[iport].messageAvailableOnLossless)
+
+    return true;
+}
+
+bool modulight::Module::readMessage(const QString &iport, MessageReader &reader)
+{
+    PortHandle port;
+
+    if (!resolveInputPort(iport, "readMessage", port))
+        return false;
+
+    return readMessage(port, reader);
+}
+
+bool modulight::Module::readMessage(const QString &iport, char *data, unsigned int size)
+{
+    PortHandle port;
+
+    if (!resolveInputPort(iport, "readMessage", port))
+        return false;
+
+    return readMessage(port, data, size);
+}
+
+bool modulight::Module::readMessage(const QString &iport, char *data, unsigned int size, unsigned int &messageSize)
+{
+    PortHandle port;
+    messageSize = 0;
+
+    if (!resolveInputPort(iport, "readMessage", port))
+        return false;
+
+    return readMessage(port, data, size, messageSize);
+}
+
+bool modulight::Module::readMessage(const PortHandle &iport, MessageReader &reader)
+{
+    if (_state != ModuleState::RUNNING)
     {
-        _inputPorts[iport].sub->recv(&msg);
-        Stamp::extractUsefulInformationFromData((char*)msg.data(), moduleIteration, portIteration, isReal, source);
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid readMessage call : the process is not running" << endl;
 
-        _inputPorts[iport].sub->recv(&msg);
-        _inputPorts[iport].messageAvailableOnLossless = false;
+        return false;
     }
-    else
+
+    if (!isInputPortHandle(iport))
+    {
+        error() << "Invalid readMessage call : invalid input port handle" << endl;
         return false;
+    }
 
-    if (isReal)
+    QMutexLocker locker(progressLock());
+
+    InputPort & port = _inputPorts[iport._index];
+    ReceivedMessage msg;
+
+    if (receiveMessage(port, msg))
     {
         reader.clear();
-        reader.load((char*)msg.data(), msg.size(), iport, source, moduleIteration, portIteration);
+        reader.load(msg.message, port.name, msg.sourceId, &_sourceNames, msg.moduleIteration, msg.portIteration);
 
         return true;
     }
@@ -697,8 +1159,30 @@ bool modulight::Module::readMessage(const QString &iport, MessageReader &reader)
         return false;
 }
 
-bool modulight::Module::readMessage(const QString &iport, char *data, unsigned int size)
+bool modulight::Module::readMessage(const PortHandle &iport, char *data, unsigned int size)
+{
+    unsigned int messageSize;
+
+    if (readMessage(iport, data, size, messageSize))
+        return true;
+
+    if (messageSize > size)
+    {
+        QMutexLocker locker(progressLock());
+        InputPort & port = _inputPorts[iport._index];
+
+        error() << "Invalid readMessage call : the message received on " << port.name.toStdString() << " (" << messageSize
+                << " bytes) is bigger than the given buffer (" << size << " bytes). The message is dropped" << endl;
+        port.sourceMessages[port.sourceOrder.takeFirst()].removeFirst();
+    }
+
+    return false;
+}
+
+bool modulight::Module::readMessage(const PortHandle &iport, char *data, unsigned int size, unsigned int &messageSize)
 {
+    messageSize = 0;
+
     if (_state != ModuleState::RUNNING)
     {
         if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
@@ -707,502 +1191,2540 @@ bool modulight::Module::readMessage(const QString &iport, char *data, unsigned i
         return false;
     }
 
-    if (!_inputPorts.contains(iport))
+    if (!isInputPortHandle(iport))
     {
-        error() << "Invalid readMessage call, no such input port (" << iport.toStdString() << ')' << endl;
+        error() << "Invalid readMessage call : invalid input port handle" << endl;
         return false;
     }
 
-     message_t msg;
-     QString source;
-     int moduleIteration;
-     int portIteration;
-     bool isReal;
+    QMutexLocker locker(progressLock());
+
+    InputPort & port = _inputPorts[iport._index];
+    ReceivedMessage msg;
 
-    if (_inputPorts[iport].messageAvailableOnLossy)
+    if (!receiveMessage(port, msg))
+        return false;
+
+    messageSize = msg.message->size();
+
+    if (messageSize > size)
     {
-        try
+        // The message is kept so that it can be read again with a big enough buffer, before any other
+        port.sourceMessages[msg.sourceId].prepend(msg);
+        releaseRingSlot(port.sourceMessages[msg.sourceId].first());
+        port.sourceOrder.prepend(msg.sourceId);
+        return false;
+    }
+
+    if (messageSize > 0)
+        memcpy(data, msg.message->data(), messageSize);
+
+    return true;
+}
+
+int modulight::Module::readMessages(const QString &iport, QVector<MessageReader> &readers, int maxCount)
+{
+    PortHandle port;
+
+    if (!resolveInputPort(iport, "readMessages", port))
+    {
+        readers.clear();
+        return 0;
+    }
+
+    return readMessages(port, readers, maxCount);
+}
+
+int modulight::Module::readMessages(const PortHandle &iport, QVector<MessageReader> &readers, int maxCount)
+{
+    int count = 0;
+
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid readMessages call : the process is not running" << endl;
+
+        readers.clear();
+        return 0;
+    }
+
+    if (!isInputPortHandle(iport))
+    {
+        error() << "Invalid readMessages call : invalid input port handle" << endl;
+        readers.clear();
+        return 0;
+    }
+
+    QMutexLocker locker(progressLock());
+
+    InputPort & port = _inputPorts[iport._index];
+    ReceivedMessage msg;
+
+    while (maxCount < 0 || count < maxCount)
+    {
+        // Messages which arrived since the last wait are read directly from the sockets of this port
+        expectMessages(port);
+
+        if (!receiveMessage(port, msg))
+            break;
+
+        releaseRingSlot(msg);
+
+        if (count == readers.size())
+            readers.append(MessageReader());
+
+        readers[count].clear();
+        readers[count].load(msg.message, port.name, msg.sourceId, &_sourceNames, msg.moduleIteration, msg.portIteration);
+        ++count;
+    }
+
+    // The readers left over from a previous call release their messages
+    readers.resize(count);
+
+    pollInputPort(port);
+
+    return count;
+}
+
+bool modulight::Module::readMessageFrom(const QString &iport, quint32 sourceId, MessageReader &reader)
+{
+    PortHandle port;
+
+    if (!resolveInputPort(iport, "readMessageFrom", port))
+        return false;
+
+    return readMessageFrom(port, sourceId, reader);
+}
+
+bool modulight::Module::readMessageFrom(const PortHandle &iport, quint32 sourceId, MessageReader &reader)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid readMessageFrom call : the process is not running" << endl;
+
+        return false;
+    }
+
+    if (!isInputPortHandle(iport))
+    {
+        error() << "Invalid readMessageFrom call : invalid input port handle" << endl;
+        return false;
+    }
+
+    QMutexLocker locker(progressLock());
+
+    InputPort & port = _inputPorts[iport._index];
+    ReceivedMessage msg;
+
+    if (!receiveMessageFrom(port, sourceId, msg))
+        return false;
+
+    reader.clear();
+    reader.load(msg.message, port.name, msg.sourceId, &_sourceNames, msg.moduleIteration, msg.portIteration);
+
+    return true;
+}
+
+quint32 modulight::Module::sourceId(const QString &sourceName)
+{
+    QMutexLocker locker(progressLock());
+
+    return _sourceNames.key(sourceName, 0);
+}
+
+bool modulight::Module::receiveMessage(InputPort &port, ReceivedMessage &message)
+{
+    // Messages put aside by readMessageFrom come first, they were received before the others
+    if (!port.sourceOrder.isEmpty())
+    {
+        QList<ReceivedMessage> & messages = port.sourceMessages[port.sourceOrder.takeFirst()];
+        message = messages.takeFirst();
+
+        return true;
+    }
+
+    return receiveUnsortedMessage(port, message);
+}
+
+bool modulight::Module::receiveMessageFrom(InputPort &port, quint32 sourceId, ReceivedMessage &message)
+{
+    QList<ReceivedMessage> & messages = port.sourceMessages[sourceId];
+
+    if (!messages.isEmpty())
+    {
+        // The first occurrence of the source in the arrival order is this message
+        port.sourceOrder.removeOne(sourceId);
+        message = messages.takeFirst();
+
+        return true;
+    }
+
+    // Every message queued on the sockets of this port is read until one of the source is met
+    while (true)
+    {
+        expectMessages(port);
+
+        if (receiveUnsortedMessage(port, message))
         {
-            _inputPorts[iport].req->recv(&msg);
-            Stamp::extractUsefulInformationFromData((char*)msg.data(), moduleIteration, portIteration, isReal, source);
+            if (message.sourceId == sourceId)
+            {
+                pollInputPort(port);
+                return true;
+            }
 
-            if (isReal)
-                _inputPorts[iport].req->recv(data, size);
-            else
-                _inputPorts[iport].req->recv(&msg);
+            putAside(port, message);
+        }
+        else if (!pollInputPort(port)) // A read also fails on an invalid or expired message, which may be followed by others
+            return false;
+    }
+}
+
+void modulight::Module::putAside(InputPort &port, const ReceivedMessage &message)
+{
+    port.sourceMessages[message.sourceId].append(message);
+    port.sourceOrder.append(message.sourceId);
+
+    releaseRingSlot(port.sourceMessages[message.sourceId].last());
+}
+
+void modulight::Module::releaseRingSlot(ReceivedMessage &message)
+{
+    // The producer only has a few slots : a message kept by the module (or read in a batch) is copied out of its slot
+    if (!message.inRing)
+        return;
+
+    QSharedPointer<message_t> copy(new message_t(message.message->size()));
+    memcpy(copy->data(), message.message->data(), message.message->size());
+
+    message.message = copy;
+    message.inRing = false;
+}
+
+bool modulight::Module::receiveUnsortedMessage(InputPort &port, ReceivedMessage &message)
+{
+    // Expired messages are released without being handed to the user (see Application::connect)
+    while (receiveNextMessage(port, message))
+    {
+        if (!isExpired(message.sendTime, port.timeToLive.value(message.sourceId, 0)))
+            return true;
+
+        ++port.expiredMessageCount;
+    }
+
+    return false;
+}
+
+bool modulight::Module::receiveNextMessage(InputPort &port, ReceivedMessage &message)
+{
+    message_t stampMsg;
+
+    // Steering messages overtake every other message, even the ones which are already known to be there
+    port.messageAvailableOnSteering = false;
+
+    if (port.steeringSub && port.steeringSub->recv(&stampMsg, ZMQ_DONTWAIT))
+    {
+        message.message = QSharedPointer<message_t>(new message_t);
+        port.steeringSub->recv(message.message.data());
+
+        return decodeMessage(port, stampMsg, message);
+    }
 
-            _inputPorts[iport].messageAvailableOnLossy = false;
+    if (port.latestOnly)
+        conflate(port);
+
+    if (!port.pendingMessages.isEmpty())
+    {
+        message = port.pendingMessages.takeFirst();
+        return true;
+    }
+
+    message.message = QSharedPointer<message_t>(new message_t);
+
+    // Availability flags may be set while the socket is empty (see expectMessages), so sockets are read without blocking
+    bool received = false;
+
+    for (int i = 0; i < port.lossyChannels.size() && !received; ++i)
+    {
+        LossyChannel & lc = port.lossyChannels[i];
+
+        if (!lc.messageAvailable)
+            continue;
+
+        lc.messageAvailable = false;
+
+        if (lc.dealer->recv(&stampMsg, ZMQ_DONTWAIT))
+        {
+            lc.dealer->recv(message.message.data());
+            received = true;
+
+            // The message is consumed, the remote can push the next one
+            lc.dealer->send(0, 0, ZMQ_DONTWAIT);
         }
-        catch(zmq::error_t &)
+    }
+
+    if (!received && port.messageAvailableOnLossless)
+    {
+        port.messageAvailableOnLossless = false;
+
+        if (port.sub->recv(&stampMsg, ZMQ_DONTWAIT))
         {
-            display() << "Exception caught in readMessage : bad recv call (bad REQ state)" << endl;
-            return false;
+            port.sub->recv(message.message.data());
+            received = true;
         }
     }
-    else if (_inputPorts[iport].messageAvailableOnLossless)
+
+    if (!received)
+        return false;
+
+    return decodeMessage(port, stampMsg, message);
+}
+
+bool modulight::Module::decodeMessage(InputPort &port, message_t &stampMsg, ReceivedMessage &message)
+{
+    Stamp stamp;
+
+    if (!Stamp::fromData(stampMsg.data(), stampMsg.size(), stamp))
     {
-        _inputPorts[iport].sub->recv(&msg);
-        Stamp::extractUsefulInformationFromData((char*)msg.data(), moduleIteration, portIteration, isReal, source);
+        error() << "Critical coherence error within modulight : invalid stamp received on " << port.name.toStdString() << endl;
+        return false;
+    }
 
-        if (isReal)
-            _inputPorts[iport].sub->recv(data, size);
-        else
-            _inputPorts[iport].sub->recv(&msg);
+    message.sourceId = stamp.sourceId();
+    message.moduleIteration = stamp.moduleIteration();
+    message.portIteration = stamp.portIteration();
+    message.sendTime = stamp.sendTime();
+
+    if (stamp.isSharedMemory() && !mapSharedMemoryMessage(port, message))
+        return false;
+
+    // Messages of a batch after the first one wait in the pending messages
+    if (stamp.isBatch() && !unpackBatch(port, message))
+        return false;
+
+    return stamp.isReal();
+}
+
+void modulight::Module::conflate(InputPort &port)
+{
+    message_t stampMsg;
+
+    // Every message waiting on the lossless socket is received without blocking, and without being copied
+    while (port.sub->recv(&stampMsg, ZMQ_DONTWAIT))
+    {
+        ReceivedMessage message;
+        message.message = QSharedPointer<message_t>(new message_t);
+        port.sub->recv(message.message.data());
+
+        if (decodeMessage(port, stampMsg, message))
+            port.pendingMessages.append(message);
+    }
+
+    port.messageAvailableOnLossless = false;
+
+    // The newest message of each source (highest port iteration) takes the place of its first message, so that sources keep their order
+    QMap<quint32, int> kept;
+    QList<ReceivedMessage> newest;
+
+    for (int i = 0; i < port.pendingMessages.size(); ++i)
+    {
+        const ReceivedMessage & m = port.pendingMessages[i];
+
+        if (!kept.contains(m.sourceId))
+        {
+            kept[m.sourceId] = newest.size();
+            newest.append(m);
+        }
+        else if (m.portIteration > newest[kept[m.sourceId]].portIteration)
+            newest[kept[m.sourceId]] = m;
+    }
+
+    port.pendingMessages = newest;
+
+    for (int i = 0; i < port.pendingMessages.size(); ++i)
+        releaseRingSlot(port.pendingMessages[i]);
+}
+
+void modulight::Module::updateMessageAvailability(long msTimeout)
+{
+    checkDynamicOrders();
+
+    // Sockets on which a message is already known to be available are not polled again,
+    // otherwise a blocking poll would return immediately because of them
+    int item = 0;
+    for (int i = 0; i < _inputPorts.size(); ++i)
+    {
+        const InputPort & ip = _inputPorts[i];
+
+        _pollItems[item++].events = ip.messageAvailableOnLossless ? 0 : ZMQ_POLLIN;
+
+        if (ip.steeringSub)
+            _pollItems[item++].events = ip.messageAvailableOnSteering ? 0 : ZMQ_POLLIN;
+
+        for (int j = 0; j < ip.lossyChannels.size(); ++j)
+            _pollItems[item++].events = ip.lossyChannels[j].messageAvailable ? 0 : ZMQ_POLLIN;
+    }
+
+    zmq_poll(_pollItems.data(), _pollItems.size(), msTimeout);
+
+    item = 0;
+    for (int i = 0; i < _inputPorts.size(); ++i)
+    {
+        InputPort & ip = _inputPorts[i];
 
-        _inputPorts[iport].messageAvailableOnLossless = false;
+        if (_pollItems[item++].revents & ZMQ_POLLIN)
+            ip.messageAvailableOnLossless = true;
+
+        if (ip.steeringSub && (_pollItems[item++].revents & ZMQ_POLLIN))
+            ip.messageAvailableOnSteering = true;
+
+        for (int j = 0; j < ip.lossyChannels.size(); ++j)
+            if (_pollItems[item++].revents & ZMQ_POLLIN)
+                ip.lossyChannels[j].messageAvailable = true;
+
+        // Stale messages are released as soon as possible rather than piling up in the socket
+        if (ip.latestOnly && ip.messageAvailableOnLossless)
+            conflate(ip);
+    }
+}
+
+void modulight::Module::expectMessages(InputPort &port)
+{
+    port.messageAvailableOnLossless = true;
+
+    for (int i = 0; i < port.lossyChannels.size(); ++i)
+        port.lossyChannels[i].messageAvailable = true;
+}
+
+bool modulight::Module::pollInputPort(InputPort &port)
+{
+    QVector<zmq_pollitem_t> items;
+
+    items.append(pollItem(*port.sub));
+
+    if (port.steeringSub)
+        items.append(pollItem(*port.steeringSub));
+
+    for (int i = 0; i < port.lossyChannels.size(); ++i)
+        items.append(pollItem(*port.lossyChannels[i].dealer));
+
+    // Flags set by expectMessages are replaced by the actual availability
+    bool available = zmq_poll(items.data(), items.size(), 0) > 0;
+    int item = 0;
+
+    port.messageAvailableOnLossless = items[item++].revents & ZMQ_POLLIN;
+
+    if (port.steeringSub && (items[item++].revents & ZMQ_POLLIN))
+        port.messageAvailableOnSteering = true;
+
+    for (int i = 0; i < port.lossyChannels.size(); ++i)
+        port.lossyChannels[i].messageAvailable = items[item++].revents & ZMQ_POLLIN;
+
+    return available;
+}
+
+void modulight::Module::serviceOnce(long msTimeout)
+{
+    handleLossyPushes();
+    drainSendQueues();
+    flushExpiredBatches();
+    flushPacedMessages();
+    updateMessageAvailability(msTimeout);
+}
+
+bool modulight::Module::nextTry(const QTime &time, int msToWait, int usToSleep, QMutexLocker &locker, long &msTimeout, int msMaxTimeout)
+{
+    if (msToWait == 0 || (msToWait > 0 && time.elapsed() >= msToWait))
+        return false;
+
+    msTimeout = pollTimeout(time, msToWait);
+
+    if (msMaxTimeout != -1)
+        msTimeout = qMin(msTimeout, (long) msMaxTimeout);
+
+    locker.unlock();
+
+    if (_waitMode == WaitMode::POLLING && usToSleep != 0)
+        usleep(usToSleep);
+
+    return true;
+}
+
+int modulight::Module::pollTimeout(const QTime &time, int msToWait) const
+{
+    if (_waitMode == WaitMode::POLLING)
+        return 0;
+
+    int period = _msDynamicOrderPeriod;
+    int msBatch = batchTimeout();
+    int msPacing = pacingTimeout();
+
+    // Pending batches must be sent on time, as well as the messages waiting for the rate limit
+    if (msBatch != -1)
+        period = qMin(period, msBatch);
+
+    if (msPacing != -1)
+        period = qMin(period, msPacing);
+
+    if (msToWait <= -1)
+        return period;
+
+    int remaining = msToWait - time.elapsed();
+
+    if (remaining <= 0)
+        return 0;
+
+    return qMin(remaining, period);
+}
+
+void modulight::Module::handleLossyPushes()
+{
+    message_t identity;
+    message_t credit;
+
+    for (int p = 0; p < _outputPorts.size(); ++p)
+    {
+        OutputPort & op = _outputPorts[p];
+
+        // Credits are received as [identity][empty frame]
+        while (op.router->recv(&identity, ZMQ_DONTWAIT))
+        {
+            op.router->recv(&credit);
+
+            quint32 remoteId;
+            int remote = -1;
+
+            if (identity.size() != 1 + sizeof(quint32))
+                continue;
+
+            memcpy(&remoteId, (char*)identity.data() + 1, sizeof(quint32));
+            remote = op.lossyRemoteIndex(remoteId);
+
+            if (remote == -1)
+            {
+                int bounded = op.boundedRemoteIndex(remoteId);
+
+                // Credits of remotes which have just been disconnected are ignored
+                if (bounded == -1)
+                    continue;
+
+                BoundedRemote & br = op.boundedRemotes[bounded];
+                qint32 credits = 1;
+
+                if (credit.size() == sizeof(qint32))
+                    memcpy(&credits, credit.data(), sizeof(qint32));
+
+                br.credits += credits;
+                pushQueuedMessages(op, br);
+                continue;
+            }
+
+            op.lossyRemotes[remote].credit = true;
+
+            if (!op.lossyRemotes[remote].sent)
+                pushLastMessage(op, op.lossyRemotes[remote]);
+        }
+    }
+}
+
+bool modulight::Module::pushLastMessage(OutputPort &op, LossyRemote &remote)
+{
+    bool sampled = remote.sampler.isEnabled();
+    const Stamp & lastStamp = sampled ? remote.sampledStamp : op.lastStamp;
+
+    if (sampled && remote.sampledMessage.isNull())
+    {
+        remote.sent = true;
+        return false;
+    }
+
+    // A stale message is not worth the bandwidth, the remote keeps its credit for the next one
+    if (isExpired(lastStamp.sendTime(), remote.msTimeToLive))
+    {
+        remote.sent = true;
+        remote.sampledMessage.clear();
+        ++op.droppedMessageCount;
+        return false;
+    }
+
+    message_t msg;
+    msg.copy(sampled ? remote.sampledMessage.data() : op.lastMessage.data());
+
+    try
+    {
+        op.router->send(remote.identity.data(), remote.identity.size(), ZMQ_SNDMORE);
+    }
+    catch(zmq::error_t &)
+    {
+        // The remote is not connected anymore (ZMQ_ROUTER_MANDATORY)
+        return false;
+    }
+
+    int reader = -1;
+
+    // The ring slot of a sampled message may have been reused since, unless it is still the last message of the port
+    if (remote.sharedMemory && op.lastInRing && lastStamp.portIteration() == op.lastStamp.portIteration())
+        reader = op.ring->readerIndex(remote.id);
+
+    if (reader != -1)
+    {
+        // The slot is held until the remote has read the message
+        Stamp stamp = lastStamp;
+        stamp.setSharedMemory(true);
+
+        op.ring->holdSlot(op.lastSlot, reader);
+
+        op.router->send(stamp.data(), stamp.size(), ZMQ_SNDMORE);
+        op.router->send(&op.lastDescriptor, sizeof(SharedMemoryDescriptor));
+    }
+    else
+    {
+        op.router->send(lastStamp.data(), lastStamp.size(), ZMQ_SNDMORE);
+        op.router->send(msg);
+    }
+
+    remote.sent = true;
+    remote.credit = false;
+    remote.sampledMessage.clear();
+
+    return true;
+}
+
+void modulight::Module::addLossyChannel(InputPort &port, const QString &remoteName, const QByteArray &endpoint)
+{
+    LossyChannel channel;
+    QByteArray identity = lossyChannelIdentity(port.id);
+    int linger = 0;
+    int hwm = 0;
+
+    channel.remoteName = remoteName;
+    channel.endpoint = endpoint;
+    channel.messageAvailable = false;
+
+    channel.dealer = new zmq::socket_t(_context, ZMQ_DEALER);
+    channel.dealer->setsockopt(ZMQ_IDENTITY, identity.data(), identity.size());
+    channel.dealer->setsockopt(ZMQ_LINGER, &linger, sizeof(int));
+    channel.dealer->setsockopt(ZMQ_RCVHWM, &hwm, sizeof(int)); // Bounded by the credits
+    channel.dealer->connect(endpoint.data());
+
+    port.lossyChannels.append(channel);
+
+    createPollItems();
+}
+
+void modulight::Module::removeLossyChannel(InputPort &port, const QString &remoteName)
+{
+    int index = port.lossyChannelIndex(remoteName);
+
+    if (index == -1)
+        return;
+
+    delete port.lossyChannels[index].dealer;
+    port.lossyChannels.remove(index);
+
+    createPollItems();
+}
+
+QString modulight::Module::currentConnectionsToString()
+{
+    QStringList connections;
+
+    for (int i = 0; i < _inputPorts.size(); ++i)
+    {
+        const InputPort & ip = _inputPorts[i];
+
+        if (!ip.losslessRemotes.isEmpty())
+            connections.append(QString("L|%1<-(%2)").arg(ip.name, ip.losslessRemotes.join(",")));
+
+        if (!ip.lossyChannels.isEmpty())
+            connections.append(QString("l|%1<-(%2)").arg(ip.name, ip.lossyRemotes().join(",")));
+    }
+
+    for (int i = 0; i < _outputPorts.size(); ++i)
+    {
+        const OutputPort & op = _outputPorts[i];
+
+        if (!op.losslessRemotes.isEmpty())
+            connections.append(QString("L|%1->(%2)").arg(op.name, op.losslessRemotes.join(",")));
+
+        if (!op.lossyRemotes.isEmpty())
+        {
+            QStringList names;
+            for (int j = 0; j < op.lossyRemotes.size(); ++j)
+                names.append(op.lossyRemotes[j].name);
+
+            connections.append(QString("l|%1->(%2)").arg(op.name, names.join(",")));
+        }
+
+        if (!op.boundedRemotes.isEmpty())
+        {
+            QStringList names;
+            for (int j = 0; j < op.boundedRemotes.size(); ++j)
+                names.append(op.boundedRemotes[j].name);
+
+            connections.append(QString("B|%1->(%2)").arg(op.name, names.join(",")));
+        }
+    }
+
+    return connections.join(",");
+}
+
+void modulight::Module::wait()
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid wait call : the process is not running" << endl;
+        return;
+    }
+
+    ++_iterationNumber;
+
+    QMutexLocker locker(progressLock());
+
+    serviceOnce();
+}
+
+bool modulight::Module::wait(const QString &iport, int msToWait, int msToSleep)
+{
+    PortHandle port;
+
+    if (!resolveInputPort(iport, "wait", port))
+        return false;
+
+    return wait(port, msToWait, msToSleep);
+}
+
+bool modulight::Module::wait(const PortHandle &iport, int msToWait, int msToSleep)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid wait call : the process is not running" << endl;
+        return false;
+    }
+
+    if (!isInputPortHandle(iport))
+    {
+        error() << "Invalid wait call : invalid input port handle" << endl;
+        return false;
+    }
+
+    int usToSleep = sleepDuration(msToSleep);
+
+    ++_iterationNumber;
+
+    QTime time;
+    time.start();
+
+    // The first try never blocks, so that messages which are already there are found immediately
+    long msTimeout = 0;
+
+    while (true)
+    {
+        QMutexLocker locker(progressLock());
+
+        serviceOnce(msTimeout);
+
+        if (_inputPorts[iport._index].messageAvailable())
+            return true;
+
+        if (!nextTry(time, msToWait, usToSleep, locker, msTimeout))
+            return false;
+    }
+}
+
+bool modulight::Module::wait(const QList<QStringList> &iports, int msToWait, int msToSleep)
+{
+    return waitAny(iports, msToWait, msToSleep) != -1;
+}
+
+int modulight::Module::waitAny(const QList<QStringList> &iports, int msToWait, int msToSleep)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid wait call : the process is not running" << endl;
+        return -1;
+    }
+
+    // Port names are resolved once, not at every try. Each set becomes a bitmask of input port indexes
+    int words = (_inputPorts.size() + 63) / 64;
+    QVector<QVector<quint64> > sets(iports.size(), QVector<quint64>(words, 0));
+
+    for (int i = 0; i < iports.size(); ++i)
+    {
+        for (int j = 0; j < iports[i].size(); ++j)
+        {
+            PortHandle port = inputPort(iports[i][j]);
+
+            if (!port.isValid())
+            {
+                error() << "Invalid wait call, no such input port (" << iports[i][j].toStdString() << ')' << endl;
+                return -1;
+            }
+
+            sets[i][port._index / 64] |= Q_UINT64_C(1) << (port._index % 64);
+        }
+    }
+
+    return waitForPortSets(sets, msToWait, msToSleep);
+}
+
+int modulight::Module::waitAny(const QList<QList<PortHandle> > &iports, int msToWait, int msToSleep)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid wait call : the process is not running" << endl;
+        return -1;
+    }
+
+    int words = (_inputPorts.size() + 63) / 64;
+    QVector<QVector<quint64> > sets(iports.size(), QVector<quint64>(words, 0));
+
+    for (int i = 0; i < iports.size(); ++i)
+    {
+        for (int j = 0; j < iports[i].size(); ++j)
+        {
+            if (!isInputPortHandle(iports[i][j]))
+            {
+                error() << "Invalid wait call : invalid input port handle" << endl;
+                return -1;
+            }
+
+            sets[i][iports[i][j]._index / 64] |= Q_UINT64_C(1) << (iports[i][j]._index % 64);
+        }
+    }
+
+    return waitForPortSets(sets, msToWait, msToSleep);
+}
+
+int modulight::Module::waitForPortSets(const QVector<QVector<quint64> > &sets, int msToWait, int msToSleep)
+{
+    int usToSleep = sleepDuration(msToSleep);
+
+    ++_iterationNumber;
+
+    QTime time;
+    time.start();
+
+    // The first try never blocks, so that messages which are already there are found immediately
+    long msTimeout = 0;
+    int words = sets.isEmpty() ? 0 : sets[0].size();
+    QVector<quint64> ready(words);
+
+    while (true)
+    {
+        QMutexLocker locker(progressLock());
+
+        serviceOnce(msTimeout);
+
+        // Readiness of every input port (lossless, lossy, steering or already received messages), as a bitmask
+        ready.fill(0);
+
+        for (int i = 0; i < _inputPorts.size() && i < words * 64; ++i)
+            if (_inputPorts[i].messageAvailable())
+                ready[i / 64] |= Q_UINT64_C(1) << (i % 64);
+
+        for (int i = 0; i < sets.size(); ++i)
+        {
+            bool ok = true;
+            for (int w = 0; w < words && ok; ++w)
+                ok = (ready[w] & sets[i][w]) == sets[i][w];
+
+            if (ok)
+                return i;
+        }
+
+        if (!nextTry(time, msToWait, usToSleep, locker, msTimeout))
+            return -1;
+    }
+}
+
+bool modulight::Module::join(const QStringList &iports, QVector<MessageReader> &readers, int msToWait,
+                             JoinPolicy::JoinPolicy policy, int msStragglerTimeout, JoinKey::JoinKey key, int msToSleep)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid join call : the process is not running" << endl;
+        return false;
+    }
+
+    if (iports.isEmpty())
+    {
+        error() << "Invalid join call : no input port given" << endl;
+        return false;
+    }
+
+    if (policy == JoinPolicy::TIMEOUT && msStragglerTimeout < 0)
+    {
+        error() << "Invalid join call : the straggler timeout must be positive or null" << endl;
+        return false;
+    }
+
+    // Port names are resolved once, not at every try
+    QVector<int> ports;
+
+    for (int i = 0; i < iports.size(); ++i)
+    {
+        PortHandle port = inputPort(iports[i]);
+
+        if (!port.isValid())
+        {
+            error() << "Invalid join call, no such input port (" << iports[i].toStdString() << ')' << endl;
+            return false;
+        }
+
+        ports.append(port._index);
+    }
+
+    int usToSleep = sleepDuration(msToSleep);
+
+    ++_iterationNumber;
+
+    QTime time;
+    time.start();
+
+    // The first try never blocks, so that messages which are already there are found immediately
+    long msTimeout = 0;
+
+    while (true)
+    {
+        QMutexLocker locker(progressLock());
+
+        serviceOnce(msTimeout);
+
+        if (releaseJoinedMessages(ports, readers, policy, msStragglerTimeout, key))
+            return true;
+
+        // The oldest incomplete iteration must be dropped on time
+        int msStraggler = policy == JoinPolicy::TIMEOUT ? stragglerTimeout(ports, msStragglerTimeout) : -1;
+
+        if (!nextTry(time, msToWait, usToSleep, locker, msTimeout, msStraggler))
+            return false;
+    }
+}
+
+bool modulight::Module::releaseJoinedMessages(const QVector<int> &ports, QVector<MessageReader> &readers, JoinPolicy::JoinPolicy policy,
+                                              int msStragglerTimeout, JoinKey::JoinKey key)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    // Every available message goes to the join buffer of its port. A message replaces the one of the same iteration, if any
+    for (int i = 0; i < ports.size(); ++i)
+    {
+        InputPort & port = _inputPorts[ports[i]];
+        ReceivedMessage msg;
+
+        while (receiveMessage(port, msg) || (pollInputPort(port) && receiveMessage(port, msg)))
+        {
+            JoinEntry & entry = port.joinMessages[key == JoinKey::PROCESS_ITERATION ? msg.moduleIteration : msg.portIteration];
+
+            entry.message = msg;
+            entry.arrivalTime = now;
+
+            releaseRingSlot(entry.message);
+        }
+    }
+
+    const QMap<int, JoinEntry> & first = _inputPorts[ports[0]].joinMessages;
+    bool found = false;
+    int released = 0;
+
+    if (policy == JoinPolicy::NEWEST)
+    {
+        // An iteration older than the oldest one buffered by another port can not be complete anymore.
+        // Buffers are also capped, in case iterations never line up
+        bool buffered = true;
+        int oldest = 0;
+
+        for (int i = 0; i < ports.size(); ++i)
+        {
+            const QMap<int, JoinEntry> & messages = _inputPorts[ports[i]].joinMessages;
+
+            if (messages.isEmpty())
+                buffered = false;
+            else if (i == 0 || messages.firstKey() > oldest)
+                oldest = messages.firstKey();
+        }
+
+        for (int i = 0; i < ports.size(); ++i)
+        {
+            QMap<int, JoinEntry> & messages = _inputPorts[ports[i]].joinMessages;
+
+            while (!messages.isEmpty() && ((buffered && messages.firstKey() < oldest) ||
+                                           messages.size() > JoinPolicy::MAX_BUFFERED_ITERATIONS))
+                messages.erase(messages.begin());
+        }
+
+        QList<int> iterations = first.keys();
+
+        for (int i = iterations.size() - 1; i >= 0 && !found; --i)
+        {
+            found = true;
+            for (int j = 1; j < ports.size() && found; ++j)
+                found = _inputPorts[ports[j]].joinMessages.contains(iterations[i]);
+
+            released = iterations[i];
+        }
+    }
+    else
+    {
+        while (!found)
+        {
+            // The oldest buffered iteration, over all the ports, is released first
+            bool buffered = false;
+            int oldest = 0;
+            qint64 arrivalTime = now;
+
+            for (int i = 0; i < ports.size(); ++i)
+            {
+                const QMap<int, JoinEntry> & messages = _inputPorts[ports[i]].joinMessages;
+
+                if (!messages.isEmpty() && (!buffered || messages.firstKey() < oldest))
+                    oldest = messages.firstKey();
+
+                buffered = buffered || !messages.isEmpty();
+            }
+
+            if (!buffered)
+                return false;
+
+            found = true;
+            for (int i = 0; i < ports.size(); ++i)
+            {
+                const QMap<int, JoinEntry> & messages = _inputPorts[ports[i]].joinMessages;
+
+                if (messages.contains(oldest))
+                    arrivalTime = qMin(arrivalTime, messages.value(oldest).arrivalTime);
+                else
+                    found = false;
+            }
+
+            if (found)
+                released = oldest;
+            else if (policy == JoinPolicy::WAIT || now - arrivalTime < msStragglerTimeout)
+                return false;
+            else
+            {
+                // The straggler waited for too long, its iteration is given up
+                for (int i = 0; i < ports.size(); ++i)
+                    _inputPorts[ports[i]].joinMessages.remove(oldest);
+            }
+        }
+    }
+
+    if (!found)
+        return false;
+
+    readers.resize(ports.size());
+
+    for (int i = 0; i < ports.size(); ++i)
+    {
+        InputPort & port = _inputPorts[ports[i]];
+        const ReceivedMessage & msg = port.joinMessages[released].message;
+
+        readers[i].clear();
+        readers[i].load(msg.message, port.name, msg.sourceId, &_sourceNames, msg.moduleIteration, msg.portIteration);
+
+        // Older iterations can not be released anymore
+        while (!port.joinMessages.isEmpty() && port.joinMessages.firstKey() <= released)
+            port.joinMessages.erase(port.joinMessages.begin());
+    }
+
+    return true;
+}
+
+int modulight::Module::stragglerTimeout(const QVector<int> &ports, int msStragglerTimeout) const
+{
+    bool buffered = false;
+    int oldest = 0;
+
+    // The oldest buffered iteration is the next one to time out
+    for (int i = 0; i < ports.size(); ++i)
+    {
+        const QMap<int, JoinEntry> & messages = _inputPorts[ports[i]].joinMessages;
+
+        if (!messages.isEmpty() && (!buffered || messages.firstKey() < oldest))
+            oldest = messages.firstKey();
+
+        buffered = buffered || !messages.isEmpty();
+    }
+
+    if (!buffered)
+        return -1;
+
+    qint64 arrivalTime = QDateTime::currentMSecsSinceEpoch();
+
+    for (int i = 0; i < ports.size(); ++i)
+    {
+        const QMap<int, JoinEntry> & messages = _inputPorts[ports[i]].joinMessages;
+
+        if (messages.contains(oldest))
+            arrivalTime = qMin(arrivalTime, messages.value(oldest).arrivalTime);
+    }
+
+    qint64 remaining = arrivalTime + msStragglerTimeout - QDateTime::currentMSecsSinceEpoch();
+
+    return remaining > 0 ? (int) remaining : 0;
+}
+
+void modulight::Module::setWaitMode(WaitMode::WaitMode mode, int msDynamicOrderPeriod)
+{
+    if (msDynamicOrderPeriod <= 0)
+    {
+        error() << "Invalid setWaitMode call : the dynamic order period must be positive" << endl;
+        return;
+    }
+
+    _waitMode = mode;
+    _msDynamicOrderPeriod = msDynamicOrderPeriod;
+}
+
+bool modulight::Module::messageAvailable(const QString & iport)
+{
+    PortHandle port;
+
+    if (!resolveInputPort(iport, "messageAvailable", port))
+        return false;
+
+    return messageAvailable(port);
+}
+
+bool modulight::Module::messageAvailable(const PortHandle &iport)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid messageAvailable call : the process is not running" << endl;
+        return false;
+    }
+
+    if (!isInputPortHandle(iport))
+    {
+        error() << "Invalid messageAvailable call : invalid input port handle" << endl;
+        return false;
+    }
+
+    QMutexLocker locker(progressLock());
+    return _inputPorts[iport._index].messageAvailable();
+}
+
+bool modulight::Module::messageAvailable(const QStringList &iports)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid messageAvailable call : the process is not running" << endl;
+        return false;
+    }
+
+    QMutexLocker locker(progressLock());
+
+    for (int i = 0; i < iports.size(); ++i)
+    {
+        PortHandle port = inputPort(iports[i]);
+
+        if (!port.isValid())
+        {
+            error() << "Invalid messageAvailable call : no such port (" << iports[i].toStdString() << ")" << endl;
+            return false;
+        }
+
+        if (!_inputPorts[port._index].messageAvailable())
+            return false;
+    }
+
+    return true;
+}
+
+bool modulight::Module::messageAvailableFrom(const QString &iport, quint32 sourceId)
+{
+    PortHandle port;
+
+    if (!resolveInputPort(iport, "messageAvailableFrom", port))
+        return false;
+
+    return messageAvailableFrom(port, sourceId);
+}
+
+bool modulight::Module::messageAvailableFrom(const PortHandle &iport, quint32 sourceId)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid messageAvailableFrom call : the process is not running" << endl;
+        return false;
+    }
+
+    if (!isInputPortHandle(iport))
+    {
+        error() << "Invalid messageAvailableFrom call : invalid input port handle" << endl;
+        return false;
+    }
+
+    QMutexLocker locker(progressLock());
+
+    InputPort & port = _inputPorts[iport._index];
+
+    if (!port.sourceMessages.value(sourceId).isEmpty())
+        return true;
+
+    // The received messages are sorted by source until one of the given source is met
+    ReceivedMessage msg;
+
+    if (!receiveMessageFrom(port, sourceId, msg))
+        return false;
+
+    // It is the newest message received, it goes back after the ones put aside
+    putAside(port, msg);
+
+    return true;
+}
+
+QStringList modulight::Module::portSources(const QString &port)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid portSources call : the process is not running" << endl;
+        return QStringList();
+    }
+
+    PortHandle handle = inputPort(port);
+
+    if (!handle.isValid())
+    {
+        error() << "Invalid portSources call : no such port (" << port.toStdString() << ")" << endl;
+        return QStringList();
+    }
+
+    QMutexLocker locker(progressLock());
+
+    const InputPort & ip = _inputPorts[handle._index];
+    return ip.losslessRemotes + ip.lossyRemotes();
+}
+
+MPI_Comm modulight::Module::mpiWorld() const
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid mpiWorld call : the process is not running" << endl;
+        return MPI_COMM_WORLD;
+    }
+
+    return _world;
+}
+
+void modulight::Module::send(const QString &port, const MessageWriter &writer)
+{
+    PortHandle handle;
+
+    if (resolveOutputPort(port, "send", handle))
+        send(handle, writer);
+}
+
+void modulight::Module::send(const QString &port, const char *data, unsigned int size)
+{
+    PortHandle handle;
+
+    if (resolveOutputPort(port, "send", handle))
+        send(handle, data, size);
+}
+
+void modulight::Module::send(const PortHandle &port, const MessageWriter &writer)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid send call : the process is not running" << endl;
+        return;
+    }
+
+    if (!isOutputPortHandle(port))
+    {
+        error() << "Invalid send call : invalid output port handle" << endl;
+        return;
+    }
+
+    QMutexLocker locker(progressLock());
+
+    OutputPort & op = _outputPorts[port._index];
+
+    // Messages posted before are sent first
+    drainSendQueue(op);
+
+    if (op.batchMaxSize > 0)
+        appendToBatch(op, writer.data(), writer.size());
+    else if (_sendMode == SendMode::ZERO_COPY)
+    {
+        // The message holds its own reference on the writer buffer (QVector implicit sharing)
+        QVector<char> * buffer = new QVector<char>(*writer._data);
+        message_t msg((void*)buffer->constData(), buffer->size(), releaseWriterBuffer, buffer);
+
+        publish(op, msg);
+    }
+    else
+    {
+        message_t msg(writer.size());
+        memcpy(msg.data(), writer.data(), writer.size());
+
+        publish(op, msg);
+    }
+}
+
+void modulight::Module::send(const PortHandle &port, const char *data, unsigned int size)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid send call : the process is not running" << endl;
+        return;
+    }
+
+    if (!isOutputPortHandle(port))
+    {
+        error() << "Invalid send call : invalid output port handle" << endl;
+        return;
+    }
+
+    QMutexLocker locker(progressLock());
+
+    OutputPort & op = _outputPorts[port._index];
+
+    // Messages posted before are sent first
+    drainSendQueue(op);
+
+    if (op.batchMaxSize > 0)
+    {
+        appendToBatch(op, data, size);
+        return;
+    }
+
+    message_t msg(size);
+    memcpy(msg.data(), data, size);
+
+    publish(op, msg);
+}
+
+void modulight::Module::send(const QStringList &ports, const MessageWriter &writer)
+{
+    QList<PortHandle> handles;
+
+    if (resolveOutputPorts(ports, "send", handles))
+        send(handles, writer);
+}
+
+void modulight::Module::send(const QStringList &ports, const char *data, unsigned int size)
+{
+    QList<PortHandle> handles;
+
+    if (resolveOutputPorts(ports, "send", handles))
+        send(handles, data, size);
+}
+
+void modulight::Module::send(const QList<PortHandle> &ports, const MessageWriter &writer)
+{
+    if (!checkOutputPortHandles(ports, "send"))
+        return;
+
+    QMutexLocker locker(progressLock());
+
+    // The payload holds its own reference on the writer buffer (QVector implicit sharing), whatever the send mode
+    QVector<char> * buffer = new QVector<char>(*writer._data);
+    message_t payload((void*)buffer->constData(), buffer->size(), releaseWriterBuffer, buffer);
+
+    sendShared(ports, payload);
+}
+
+void modulight::Module::send(const QList<PortHandle> &ports, const char *data, unsigned int size)
+{
+    if (!checkOutputPortHandles(ports, "send"))
+        return;
+
+    QMutexLocker locker(progressLock());
+
+    message_t payload(size);
+    memcpy(payload.data(), data, size);
+
+    sendShared(ports, payload);
+}
+
+void modulight::Module::send(const QString &port, const MessageReader &reader)
+{
+    PortHandle handle;
+
+    if (!resolveOutputPort(port, "send", handle))
+        return;
+
+    send(handle, reader);
+}
+
+void modulight::Module::send(const PortHandle &port, const MessageReader &reader)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid send call : the process is not running" << endl;
+        return;
+    }
+
+    if (!isOutputPortHandle(port))
+    {
+        error() << "Invalid send call : invalid output port handle" << endl;
+        return;
+    }
+
+    if (!reader._loaded)
+    {
+        error() << "Invalid send call : the MessageReader does not hold any received message" << endl;
+        return;
+    }
+
+    QMutexLocker locker(progressLock());
+
+    sendReceived(_outputPorts[port._index], reader._message);
+}
+
+bool modulight::Module::forward(const QString &iport, const QString &oport)
+{
+    PortHandle input, output;
+
+    if (!resolveInputPort(iport, "forward", input) ||
+        !resolveOutputPort(oport, "forward", output))
+        return false;
+
+    return forward(input, output);
+}
+
+bool modulight::Module::forward(const PortHandle &iport, const PortHandle &oport)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid forward call : the process is not running" << endl;
+        return false;
+    }
+
+    if (!isInputPortHandle(iport))
+    {
+        error() << "Invalid forward call : invalid input port handle" << endl;
+        return false;
+    }
+
+    if (!isOutputPortHandle(oport))
+    {
+        error() << "Invalid forward call : invalid output port handle" << endl;
+        return false;
+    }
+
+    QMutexLocker locker(progressLock());
+
+    ReceivedMessage msg;
+
+    if (!receiveMessage(_inputPorts[iport._index], msg))
+        return false;
+
+    sendReceived(_outputPorts[oport._index], msg.message);
+
+    return true;
+}
+
+bool modulight::Module::checkOutputPortHandles(const QList<PortHandle> &ports, const char *method)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid " << method << " call : the process is not running" << endl;
+        return false;
+    }
+
+    for (int i = 0; i < ports.size(); ++i)
+    {
+        if (!isOutputPortHandle(ports[i]))
+        {
+            error() << "Invalid " << method << " call : invalid output port handle" << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool modulight::Module::resolveOutputPorts(const QStringList &names, const char *method, QList<PortHandle> &ports)
+{
+    ports.clear();
+
+    for (int i = 0; i < names.size(); ++i)
+    {
+        PortHandle handle;
+
+        if (!resolveOutputPort(names[i], method, handle))
+            return false;
+
+        ports.append(handle);
+    }
+
+    return true;
+}
+
+void modulight::Module::sendShared(const QList<PortHandle> &ports, message_t &payload)
+{
+    for (int i = 0; i < ports.size(); ++i)
+    {
+        OutputPort & op = _outputPorts[ports[i]._index];
+
+        // Messages posted before are sent first
+        drainSendQueue(op);
+
+        if (op.batchMaxSize > 0)
+            appendToBatch(op, (const char *) payload.data(), payload.size());
+        else
+        {
+            // Each port sends a reference on the payload (reference counted by ZeroMQ), it is not copied
+            message_t msg;
+            msg.copy(&payload);
+
+            publish(op, msg);
+        }
+    }
+}
+
+void modulight::Module::sendReceived(OutputPort &op, const QSharedPointer<message_t> &message)
+{
+    // Messages posted before are sent first
+    drainSendQueue(op);
+
+    if (op.batchMaxSize > 0)
+        appendToBatch(op, (const char *) message->data(), message->size());
+    else
+    {
+        // The received content (a socket buffer, a batch entry or a shared memory slot) is referenced, not copied.
+        // It stays alive as long as ZeroMQ or the reader need it
+        message_t msg;
+        msg.copy(message.data());
+
+        publish(op, msg);
+    }
+}
+
+void modulight::Module::sendSteering(const QString &port, const MessageWriter &writer)
+{
+    PortHandle handle;
+
+    if (resolveOutputPort(port, "sendSteering", handle))
+        sendSteering(handle, writer);
+}
+
+void modulight::Module::sendSteering(const QString &port, const char *data, unsigned int size)
+{
+    PortHandle handle;
+
+    if (resolveOutputPort(port, "sendSteering", handle))
+        sendSteering(handle, data, size);
+}
+
+void modulight::Module::sendSteering(const PortHandle &port, const MessageWriter &writer)
+{
+    sendSteering(port, writer.data(), writer.size());
+}
+
+void modulight::Module::sendSteering(const PortHandle &port, const char *data, unsigned int size)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid sendSteering call : the process is not running" << endl;
+        return;
+    }
+
+    if (!isOutputPortHandle(port))
+    {
+        error() << "Invalid sendSteering call : invalid output port handle" << endl;
+        return;
+    }
+
+    QMutexLocker locker(progressLock());
+
+    OutputPort & op = _outputPorts[port._index];
+
+    if (!op.steeringPub)
+    {
+        error() << "Invalid sendSteering call : the port " << op.name.toStdString()
+                << " has no steering lane (see PortFlag::STEERING_LANE)" << endl;
+        return;
+    }
+
+    publishSteering(op, data, size);
+}
+
+void modulight::Module::postMessage(const QString &port, const MessageWriter &writer)
+{
+    PortHandle handle;
+
+    if (resolveOutputPort(port, "postMessage", handle))
+        postMessage(handle, writer);
+}
+
+void modulight::Module::postMessage(const QString &port, const char *data, unsigned int size)
+{
+    PortHandle handle;
+
+    if (resolveOutputPort(port, "postMessage", handle))
+        postMessage(handle, data, size);
+}
+
+void modulight::Module::postMessage(const PortHandle &port, const MessageWriter &writer)
+{
+    SendQueue::Message * message = new SendQueue::Message;
+    message->data = *writer._data; // Implicitly shared
+
+    postMessage(port, message);
+}
+
+void modulight::Module::postMessage(const PortHandle &port, const char *data, unsigned int size)
+{
+    SendQueue::Message * message = new SendQueue::Message;
+    message->data.resize(size);
+    memcpy(message->data.data(), data, size);
+
+    postMessage(port, message);
+}
+
+void modulight::Module::postMessage(const PortHandle &port, SendQueue::Message *message)
+{
+    // No lock is taken here : the ports are only read, and the queue is lock-free
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid postMessage call : the process is not running" << endl;
+
+        delete message;
+        return;
+    }
+
+    if (!isOutputPortHandle(port))
+    {
+        error() << "Invalid postMessage call : invalid output port handle" << endl;
+
+        delete message;
+        return;
+    }
+
+    _outputPorts.at(port._index).sendQueue->push(message);
+}
+
+void modulight::Module::drainSendQueue(OutputPort &op)
+{
+    if (op.sendQueue->isEmpty())
+        return;
+
+    SendQueue::Message * message = op.sendQueue->takeAll();
+
+    while (message)
+    {
+        if (op.batchMaxSize > 0)
+            appendToBatch(op, message->data.constData(), message->data.size());
+        else
+        {
+            // The message keeps the posted buffer alive until it is sent
+            QVector<char> * buffer = new QVector<char>(message->data);
+            message_t msg((void*)buffer->constData(), buffer->size(), releaseWriterBuffer, buffer);
+
+            publish(op, msg);
+        }
+
+        SendQueue::Message * next = message->next;
+        delete message;
+        message = next;
+    }
+}
+
+void modulight::Module::drainSendQueues()
+{
+    for (int p = 0; p < _outputPorts.size(); ++p)
+        drainSendQueue(_outputPorts[p]);
+}
+
+bool modulight::Module::setBatching(const QString &port, int maxBytes, int msMaxDelay)
+{
+    PortHandle handle;
+
+    if (!resolveOutputPort(port, "setBatching", handle))
+        return false;
+
+    return setBatching(handle, maxBytes, msMaxDelay);
+}
+
+bool modulight::Module::setBatching(const PortHandle &port, int maxBytes, int msMaxDelay)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid setBatching call : the process is not running" << endl;
+        return false;
+    }
+
+    if (!isOutputPortHandle(port))
+    {
+        error() << "Invalid setBatching call : invalid output port handle" << endl;
+        return false;
+    }
+
+    if (maxBytes < 0 || msMaxDelay < 0)
+    {
+        error() << "Invalid setBatching call : the thresholds must not be negative" << endl;
+        return false;
+    }
+
+    QMutexLocker locker(progressLock());
+    OutputPort & op = _outputPorts[port._index];
+
+    flushBatch(op);
+
+    op.batchMaxSize = maxBytes;
+    op.msBatchDelay = msMaxDelay;
+    op.batch.reserve(maxBytes);
+
+    return true;
+}
+
+void modulight::Module::flush(const QString &port)
+{
+    PortHandle handle;
+
+    if (resolveOutputPort(port, "flush", handle))
+        flush(handle);
+}
+
+void modulight::Module::flush(const PortHandle &port)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid flush call : the process is not running" << endl;
+        return;
+    }
+
+    if (!isOutputPortHandle(port))
+    {
+        error() << "Invalid flush call : invalid output port handle" << endl;
+        return;
+    }
+
+    QMutexLocker locker(progressLock());
+    OutputPort & op = _outputPorts[port._index];
+
+    drainSendQueue(op);
+    flushBatch(op);
+}
+
+bool modulight::Module::setLatestOnly(const QString &iport, bool latestOnly)
+{
+    PortHandle handle;
+
+    if (!resolveInputPort(iport, "setLatestOnly", handle))
+        return false;
+
+    return setLatestOnly(handle, latestOnly);
+}
+
+bool modulight::Module::setLatestOnly(const PortHandle &iport, bool latestOnly)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid setLatestOnly call : the process is not running" << endl;
+        return false;
+    }
+
+    if (!isInputPortHandle(iport))
+    {
+        error() << "Invalid setLatestOnly call : invalid input port handle" << endl;
+        return false;
+    }
+
+    QMutexLocker locker(progressLock());
+    _inputPorts[iport._index].latestOnly = latestOnly;
+
+    return true;
+}
+
+bool modulight::Module::setRateLimit(const QString &oport, double messagesPerSecond, double bytesPerSecond,
+                                     QueuePolicy::QueuePolicy policy)
+{
+    PortHandle handle;
+
+    if (!resolveOutputPort(oport, "setRateLimit", handle))
+        return false;
+
+    return setRateLimit(handle, messagesPerSecond, bytesPerSecond, policy);
+}
+
+bool modulight::Module::setRateLimit(const PortHandle &oport, double messagesPerSecond, double bytesPerSecond,
+                                     QueuePolicy::QueuePolicy policy)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid setRateLimit call : the process is not running" << endl;
+        return false;
+    }
+
+    if (!isOutputPortHandle(oport))
+    {
+        error() << "Invalid setRateLimit call : invalid output port handle" << endl;
+        return false;
+    }
+
+    if (messagesPerSecond < 0 || bytesPerSecond < 0)
+    {
+        error() << "Invalid setRateLimit call : rates cannot be negative" << endl;
+        return false;
+    }
+
+    if (policy != QueuePolicy::BLOCK && policy != QueuePolicy::DROP_OLDEST && policy != QueuePolicy::DROP_NEWEST)
+    {
+        error() << "Invalid setRateLimit call : the policy must be BLOCK, DROP_OLDEST or DROP_NEWEST" << endl;
+        return false;
+    }
+
+    QMutexLocker locker(progressLock());
+
+    OutputPort & op = _outputPorts[oport._index];
+
+    // The waiting message is not held back by the new limit
+    flushPacedMessage(op, true);
+
+    op.rateLimiter.setRate(messagesPerSecond, bytesPerSecond);
+    op.ratePolicy = policy;
+
+    return true;
+}
+
+quint64 modulight::Module::expiredMessageCount(const QString &iport)
+{
+    PortHandle handle;
+
+    if (!resolveInputPort(iport, "expiredMessageCount", handle))
+        return 0;
+
+    return expiredMessageCount(handle);
+}
+
+quint64 modulight::Module::expiredMessageCount(const PortHandle &iport)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid expiredMessageCount call : the process is not running" << endl;
+        return 0;
+    }
+
+    if (!isInputPortHandle(iport))
+    {
+        error() << "Invalid expiredMessageCount call : invalid input port handle" << endl;
+        return 0;
+    }
+
+    QMutexLocker locker(progressLock());
+    return _inputPorts[iport._index].expiredMessageCount;
+}
+
+quint64 modulight::Module::droppedMessageCount(const QString &oport)
+{
+    PortHandle handle;
+
+    if (!resolveOutputPort(oport, "droppedMessageCount", handle))
+        return 0;
+
+    return droppedMessageCount(handle);
+}
+
+quint64 modulight::Module::droppedMessageCount(const PortHandle &oport)
+{
+    if (_state != ModuleState::RUNNING)
+    {
+        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
+            error() << "Invalid droppedMessageCount call : the process is not running" << endl;
+        return 0;
+    }
+
+    if (!isOutputPortHandle(oport))
+    {
+        error() << "Invalid droppedMessageCount call : invalid output port handle" << endl;
+        return 0;
+    }
+
+    QMutexLocker locker(progressLock());
+    return _outputPorts[oport._index].droppedMessageCount;
+}
+
+void modulight::Module::appendToBatch(OutputPort &op, const char *data, int size)
+{
+    ++op.iterationNumber;
+
+    if (op.batch.isEmpty())
+        op.batchTime.start();
+
+    BatchEntry entry;
+    entry.moduleIteration = _iterationNumber;
+    entry.portIteration = op.iterationNumber;
+    entry.size = size;
+
+    int offset = op.batch.size();
+    op.batch.resize(offset + sizeof(BatchEntry) + size);
+
+    memcpy(op.batch.data() + offset, &entry, sizeof(BatchEntry));
+    memcpy(op.batch.data() + offset + sizeof(BatchEntry), data, size);
+
+    if (op.batch.size() >= op.batchMaxSize || op.batchTime.elapsed() >= op.msBatchDelay)
+        flushBatch(op);
+}
+
+void modulight::Module::flushBatch(OutputPort &op)
+{
+    if (op.batch.isEmpty())
+        return;
+
+    // The message takes the batch buffer itself, a new one is allocated for the next batch
+    QVector<char> * buffer = new QVector<char>(op.batch);
+    message_t msg((void*)buffer->constData(), buffer->size(), releaseWriterBuffer, buffer);
+
+    op.batch.clear();
+    op.batch.reserve(op.batchMaxSize);
+
+    Stamp stamp(true, op.id, _iterationNumber, op.iterationNumber);
+    stamp.setBatch(true);
+
+    publish(op, stamp, msg);
+}
+
+void modulight::Module::flushExpiredBatches()
+{
+    for (int p = 0; p < _outputPorts.size(); ++p)
+    {
+        OutputPort & op = _outputPorts[p];
+
+        if (!op.batch.isEmpty() && op.batchTime.elapsed() >= op.msBatchDelay)
+            flushBatch(op);
+    }
+}
+
+int modulight::Module::batchTimeout() const
+{
+    int timeout = -1;
+
+    for (int p = 0; p < _outputPorts.size(); ++p)
+    {
+        const OutputPort & op = _outputPorts[p];
+
+        if (!op.batch.isEmpty())
+        {
+            int remaining = qMax(0, op.msBatchDelay - op.batchTime.elapsed());
+
+            if (timeout == -1 || remaining < timeout)
+                timeout = remaining;
+        }
+    }
+
+    return timeout;
+}
+
+bool modulight::Module::unpackBatch(InputPort &port, ReceivedMessage &message)
+{
+    QSharedPointer<message_t> batch = message.message;
+    const char * data = (const char *) batch->data();
+    int size = batch->size();
+    int offset = 0;
+
+    QList<ReceivedMessage> entries;
+
+    while (offset < size)
+    {
+        BatchEntry entry;
+
+        if (offset + (int)sizeof(BatchEntry) > size)
+            break;
+
+        memcpy(&entry, data + offset, sizeof(BatchEntry));
+        offset += sizeof(BatchEntry);
+
+        if (entry.size < 0 || offset + entry.size > size)
+            break;
+
+        // Each message points into the batch, which is kept alive until all of them are destroyed
+        ReceivedMessage m;
+        m.message = QSharedPointer<message_t>(new message_t((void*)(data + offset), entry.size, releaseBatchEntry,
+                                                            new QSharedPointer<message_t>(batch)));
+        m.sourceId = message.sourceId;
+        m.moduleIteration = entry.moduleIteration;
+        m.portIteration = entry.portIteration;
+        m.sendTime = message.sendTime;
+
+        entries.append(m);
+        offset += entry.size;
+    }
+
+    if (offset != size || entries.isEmpty())
+    {
+        error() << "Critical coherence error within modulight : invalid batch received on " << port.name.toStdString() << endl;
+        return false;
+    }
+
+    message = entries.takeFirst();
+    port.pendingMessages += entries;
+
+    return true;
+}
+
+void modulight::Module::publish(OutputPort &op, message_t &msg)
+{
+    ++op.iterationNumber;
+
+    Stamp stamp(true, op.id, _iterationNumber, op.iterationNumber);
+
+    publish(op, stamp, msg);
+}
+
+void modulight::Module::publish(OutputPort &op, const Stamp &stamp, message_t &msg)
+{
+    if (op.rateLimiter.isEnabled() && !pace(op, stamp, msg))
+        return;
+
+    transmit(op, stamp, msg);
+}
+
+void modulight::Module::transmit(OutputPort &op, const Stamp &stamp, message_t &msg)
+{
+    if (!op.sharedMemoryReaders.isEmpty())
+        publishSharedMemory(op, stamp, msg);
+
+    if (!op.boundedRemotes.isEmpty())
+        queueForBoundedRemotes(op, stamp, msg);
+
+    if (op.lossyRemotes.isEmpty())
+    {
+        op.pub->send(stamp.data(), stamp.size(), ZMQ_SNDMORE);
+        op.pub->send(msg);
+        return;
+    }
+
+    // The last value shares the message content (reference counted by ZeroMQ), it is not copied
+    op.lastMessage->copy(&msg);
+    op.lastStamp = stamp;
+
+    op.pub->send(stamp.data(), stamp.size(), ZMQ_SNDMORE);
+    op.pub->send(msg);
+
+    // Remotes which already consumed the previous message get this one right now, the others once they have
+    for (int i = 0; i < op.lossyRemotes.size(); ++i)
+    {
+        LossyRemote & remote = op.lossyRemotes[i];
+
+        // A message skipped by the sampling of the remote leaves the last accepted one waiting for a credit
+        if (!remote.sampler.accept(stamp))
+            continue;
+
+        if (remote.sampler.isEnabled())
+        {
+            remote.sampledMessage = QSharedPointer<message_t>(new message_t);
+            remote.sampledMessage->copy(&msg);
+            remote.sampledStamp = stamp;
+        }
+
+        remote.sent = false;
+
+        if (remote.credit)
+            pushLastMessage(op, remote);
+    }
+}
+
+void modulight::Module::publishSteering(OutputPort &op, const char *data, unsigned int size)
+{
+    ++op.steeringIterationNumber;
+
+    Stamp stamp(true, op.id, _iterationNumber, op.steeringIterationNumber);
+
+    op.steeringPub->send(stamp.data(), stamp.size(), ZMQ_SNDMORE);
+    op.steeringPub->send(data, size);
+}
+
+void modulight::Module::connectSteeringLane(InputPort &port, const QString &remoteName, const QString &remoteIP,
+                                            quint16 steeringPort, const QString &steeringIpc)
+{
+    // The master only gives a steering endpoint when both ports have a lane
+    if (steeringPort == 0 || !port.steeringSub)
+        return;
+
+    QByteArray endpoint = remoteEndpoint(remoteIP, steeringPort, steeringIpc);
+
+    port.steeringSub->connect(endpoint.data());
+    port.steeringRemotes[remoteName] = endpoint;
+}
+
+void modulight::Module::disconnectSteeringLane(InputPort &port, const QString &remoteName)
+{
+    QMap<QString, QByteArray>::iterator it = port.steeringRemotes.find(remoteName);
+
+    if (it == port.steeringRemotes.end())
+        return;
+
+    zmq_disconnect(*port.steeringSub, it.value().data());
+    port.steeringRemotes.erase(it);
+}
+
+bool modulight::Module::pace(OutputPort &op, const Stamp &stamp, message_t &msg)
+{
+    switch (op.ratePolicy)
+    {
+    case QueuePolicy::DROP_NEWEST:
+        if (op.rateLimiter.consume(msg.size()))
+            return true;
+
+        ++op.droppedMessageCount;
+        return false;
+    case QueuePolicy::DROP_OLDEST:
+        // The waiting message, if any, is older than this one : it must not be sent after it
+        if (op.pacedMessage.isNull() && op.rateLimiter.consume(msg.size()))
+            return true;
+
+        if (!op.pacedMessage.isNull())
+            ++op.droppedMessageCount;
+
+        op.pacedStamp = stamp;
+        op.pacedMessage = QSharedPointer<message_t>(new message_t);
+        op.pacedMessage->move(&msg);
+        return false;
+    default:
+        waitForTokens(op, msg.size());
+        return true;
+    }
+}
+
+void modulight::Module::waitForTokens(OutputPort &op, int size)
+{
+    int ms;
+
+    ++_sendWaitDepth;
+
+    while ((ms = op.rateLimiter.msUntilAvailable(size)) > 0)
+    {
+        // Consumers keep being served while the producer is held back
+        handleLossyPushes();
+        checkDynamicOrders();
+        usleep(qMin(ms, _msDynamicOrderPeriod) * 1000);
+    }
+
+    --_sendWaitDepth;
+
+    op.rateLimiter.consume(size);
+}
+
+void modulight::Module::flushPacedMessage(OutputPort &op, bool force)
+{
+    if (op.pacedMessage.isNull())
+        return;
+
+    if (!force && !op.rateLimiter.consume(op.pacedMessage->size()))
+        return;
+
+    QSharedPointer<message_t> msg = op.pacedMessage;
+    op.pacedMessage.clear();
+
+    transmit(op, op.pacedStamp, *msg);
+}
+
+void modulight::Module::flushPacedMessages()
+{
+    for (int p = 0; p < _outputPorts.size(); ++p)
+        flushPacedMessage(_outputPorts[p], false);
+}
+
+int modulight::Module::pacingTimeout() const
+{
+    int timeout = -1;
+
+    for (int p = 0; p < _outputPorts.size(); ++p)
+    {
+        const OutputPort & op = _outputPorts[p];
+
+        if (!op.pacedMessage.isNull())
+        {
+            int remaining = op.rateLimiter.msUntilAvailable(op.pacedMessage->size());
+
+            if (timeout == -1 || remaining < timeout)
+                timeout = remaining;
+        }
     }
-    else
-        return false;
 
-    if (isReal)
-        return true;
-    else
-        return false;
+    return timeout;
 }
 
-void modulight::Module::updateMessageAvailability()
+void modulight::Module::applyRateLimitArguments()
 {
-    checkDynamicOrders();
-
-    zmq_poll(_pollItems.data(), _pollItems.size(), 0);
-
-    QMutableMapIterator<QString, InputPort> it(_inputPorts);
-    for (int i = 0; it.hasNext(); ++i)
+    for (int p = 0; p < _outputPorts.size(); ++p)
     {
-        it.next();
+        QString prefix = QString("modulight.rateLimit.%1.").arg(_outputPorts[p].name);
 
-        if (_pollItems[i*2  ].revents & ZMQ_POLLIN)
-            it.value().messageAvailableOnLossless = true;
-        if (_pollItems[i*2+1].revents & ZMQ_POLLIN)
-            it.value().messageAvailableOnLossy = true;
+        double messagesPerSecond = _arguments.getDouble(prefix + "messages", 0);
+        double bytesPerSecond = _arguments.getDouble(prefix + "bytes", 0);
+        int policy = _arguments.getInt(prefix + "policy", QueuePolicy::BLOCK);
+
+        if (messagesPerSecond > 0 || bytesPerSecond > 0)
+            setRateLimit(PortHandle(p, false), messagesPerSecond, bytesPerSecond, (QueuePolicy::QueuePolicy) policy);
     }
 }
 
-void modulight::Module::handleOnRequestSends()
+void modulight::Module::queueForBoundedRemotes(OutputPort &op, const Stamp &stamp, message_t &msg)
 {
-    message_t msg;
+    // Remotes are looked up by id, as blocking handles dynamic orders which may add or remove some
+    QList<quint32> ids;
+    for (int i = 0; i < op.boundedRemotes.size(); ++i)
+        ids.append(op.boundedRemotes[i].id);
 
-    QMapIterator<QString, InputPort> itIn(_inputPorts);
-    while (itIn.hasNext())
+    for (int i = 0; i < ids.size(); ++i)
     {
-        itIn.next();
+        int index = op.boundedRemoteIndex(ids[i]);
 
-        if (!itIn.value().lossyRemotes.isEmpty())
-            zmq_send(*itIn.value().req, itIn.value().completePortName.data(), itIn.value().completePortName.size(), ZMQ_DONTWAIT);
-    }
+        if (index == -1)
+            continue;
 
-    QMutableMapIterator<QString, OutputPort> itOut(_outputPorts);
-    while (itOut.hasNext())
-    {
-        itOut.next();
+        BoundedRemote & r = op.boundedRemotes[index];
 
-        int lossyRemoteSize = itOut.value().lossyRemotes.size();
+        // Messages skipped by the sampling of the remote are never sent to it
+        if (!r.sampler.accept(stamp))
+            continue;
 
-        for (int i = 0; i < lossyRemoteSize && itOut.value().rep->recv(&msg, ZMQ_DONTWAIT); ++i)
+        if (r.policy == QueuePolicy::ADAPTIVE && (r.degraded || r.queue.size() >= r.bound))
         {
-            QString remote = QString::fromUtf8((char*)msg.data(), msg.size());
-
-            if (!itOut.value().lossyRemotes.contains(remote))
-            {
-                error() << "Critical coherence error within modulight : request from an unknown source received (" << remote.toStdString() << ')' << endl;
-                qDebug() << "Lossy : " << itOut.value().lossyRemotes;
-                qDebug() << "Lossless : " << itOut.value().losslessRemotes;
-            }
-            else
+            // The remote lags a whole queue behind : the connection acts as a lossy one until it has caught up
+            r.degraded = true;
+            op.droppedMessageCount += r.queue.size();
+            r.queue.clear();
+        }
+        else if (r.queue.size() >= r.bound)
+        {
+            switch (op.boundedRemotes[index].policy)
             {
-                if (!itOut.value().lossyRemotes[remote])
-                {
-                    itOut.value().rep->send(itOut.value().lastStamp.data(),
-                                            itOut.value().lastStamp.size(),
-                                            ZMQ_SNDMORE);
-
-                    itOut.value().rep->send(itOut.value().lastMessageBuffer.data(),
-                                            itOut.value().lastMessageBuffer.size());
-
-                    itOut.value().lossyRemotes[remote] = true;
-                }
-                else
-                {
-                    Stamp fakeStamp(false, &itOut.value().completePortName,
-                                    itOut.value().lastStamp.moduleIteration(),
-                                    itOut.value().lastStamp.portIteration());
+            case QueuePolicy::DROP_NEWEST:
+                ++op.droppedMessageCount;
+                continue;
+            case QueuePolicy::DROP_OLDEST:
+                op.boundedRemotes[index].queue.removeFirst();
+                ++op.droppedMessageCount;
+                break;
+            default:
+                waitForBoundedRemote(op, ids[i]);
+                index = op.boundedRemoteIndex(ids[i]);
 
-                    itOut.value().rep->send(fakeStamp.data(), fakeStamp.size(), ZMQ_SNDMORE);
-                    itOut.value().rep->send(0, 0);
-                }
+                if (index == -1)
+                    continue;
             }
         }
+
+        // The queued message shares the content of msg (reference counted by ZeroMQ)
+        QueuedMessage queued;
+        queued.stamp = stamp;
+        queued.message = QSharedPointer<message_t>(new message_t);
+        queued.message->copy(&msg);
+
+        BoundedRemote & remote = op.boundedRemotes[index];
+        remote.queue.append(queued);
+        pushQueuedMessages(op, remote);
     }
 }
 
-QString modulight::Module::currentConnectionsToString()
+void modulight::Module::pushQueuedMessages(OutputPort &op, BoundedRemote &remote)
 {
-    QStringList connections;
-
-    QMapIterator<QString, InputPort> itIn(_inputPorts);
-    while (itIn.hasNext())
+    while (remote.credits > 0 && !remote.queue.isEmpty())
     {
-        itIn.next();
+        QueuedMessage & queued = remote.queue.first();
 
-        if (!itIn.value().losslessRemotes.isEmpty())
-            connections.append(QString("L|%1<-(%2)").arg(itIn.key(), itIn.value().losslessRemotes.join(",")));
-
-        if (!itIn.value().lossyRemotes.isEmpty())
-            connections.append(QString("l|%1<-(%2)").arg(itIn.key(), itIn.value().lossyRemotes.join(",")));
-    }
+        if (isExpired(queued.stamp.sendTime(), remote.msTimeToLive))
+        {
+            remote.queue.removeFirst();
+            ++op.droppedMessageCount;
+            continue;
+        }
 
-    QMapIterator<QString, OutputPort> itOut(_outputPorts);
-    while (itOut.hasNext())
-    {
-        itOut.next();
+        try
+        {
+            op.router->send(remote.identity.data(), remote.identity.size(), ZMQ_SNDMORE);
+        }
+        catch(zmq::error_t &)
+        {
+            // The remote is not connected anymore (ZMQ_ROUTER_MANDATORY)
+            return;
+        }
 
-        if (!itOut.value().losslessRemotes.isEmpty())
-            connections.append(QString("L|%1->(%2)").arg(itOut.key(), itOut.value().losslessRemotes.join(",")));
+        op.router->send(queued.stamp.data(), queued.stamp.size(), ZMQ_SNDMORE);
+        op.router->send(*queued.message);
 
-        if (!itOut.value().lossyRemotes.isEmpty())
-            connections.append(QString("l|%1->(%2)").arg(itOut.key(), QStringList(itOut.value().lossyRemotes.keys()).join(",")));
+        remote.queue.removeFirst();
+        --remote.credits;
     }
 
-    return connections.join(",");
+    // The remote has read at least half of the messages in transit, the connection is lossless again
+    if (remote.degraded && remote.queue.isEmpty() && remote.credits * 2 >= remote.bound)
+        remote.degraded = false;
 }
 
-void modulight::Module::wait()
+void modulight::Module::waitForBoundedRemote(OutputPort &op, quint32 remoteId)
 {
-    if (_state != ModuleState::RUNNING)
-    {
-        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
-            error() << "Invalid wait call : the process is not running" << endl;
-        return;
-    }
+    zmq_pollitem_t item = pollItem(*op.router);
 
-    ++_iterationNumber;
-
-    handleOnRequestSends();
-    updateMessageAvailability();
-}
+    ++_sendWaitDepth;
 
-bool modulight::Module::wait(const QString &iport, int msToWait, int msToSleep)
-{
-    if (_state != ModuleState::RUNNING)
+    while (true)
     {
-        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
-            error() << "Invalid wait call : the process is not running" << endl;
-        return false;
-    }
+        handleLossyPushes();
 
-    if (!_inputPorts.contains(iport))
-    {
-        error() << "Invalid wait call, no such input port (" << iport.toStdString() << ')' << endl;
-        return false;
-    }
+        int index = op.boundedRemoteIndex(remoteId);
 
-    // Converting ms to µs
-    if (msToSleep > 0)
-        msToSleep *= 1000;
-    else if (msToSleep < 0)
-        msToSleep = 1;
+        if (index == -1 || op.boundedRemotes[index].queue.size() < op.boundedRemotes[index].bound)
+        {
+            --_sendWaitDepth;
+            return;
+        }
 
-    ++_iterationNumber;
+        // The remote may be disconnected by a dynamic order while it does not read its messages
+        checkDynamicOrders();
+        zmq_poll(&item, 1, _msDynamicOrderPeriod);
+    }
+}
 
-    if (msToWait <= -1)
-    {
-        while (true)
-        {
-            handleOnRequestSends();
-            updateMessageAvailability();
+void modulight::Module::publishSharedMemory(OutputPort &op, const Stamp &stamp, message_t &msg)
+{
+    handleSharedMemorySubscriptions(op);
 
-            if (_inputPorts[iport].messageAvailableOnLossless || _inputPorts[iport].messageAvailableOnLossy)
-                return true;
+    op.lastInRing = (int)msg.size() >= SharedMemoryRing::MIN_MESSAGE_SIZE && writeSharedMemory(op, msg);
 
-            if (msToSleep != 0)
-                usleep(msToSleep);
-        }
-    }
-    else if (msToWait == 0)
+    if (!op.hasLosslessSharedMemoryReader())
+        return;
+
+    if (op.lastInRing)
     {
-        handleOnRequestSends();
-        updateMessageAvailability();
+        Stamp descriptorStamp = stamp;
+        descriptorStamp.setSharedMemory(true);
 
-        if (_inputPorts[iport].messageAvailableOnLossless || _inputPorts[iport].messageAvailableOnLossy)
-            return true;
+        op.shmPub->send(descriptorStamp.data(), descriptorStamp.size(), ZMQ_SNDMORE);
+        op.shmPub->send(&op.lastDescriptor, sizeof(SharedMemoryDescriptor));
     }
     else
     {
-        QTime time;
-        time.start();
-
-        while (time.elapsed() < msToWait)
-        {
-            handleOnRequestSends();
-            updateMessageAvailability();
-
-            if (_inputPorts[iport].messageAvailableOnLossless || _inputPorts[iport].messageAvailableOnLossy)
-                return true;
+        message_t copy;
+        copy.copy(&msg);
 
-            if (msToSleep != 0)
-                usleep(msToSleep);
-        }
+        op.shmPub->send(stamp.data(), stamp.size(), ZMQ_SNDMORE);
+        op.shmPub->send(copy);
     }
-
-    return false;
 }
 
-bool modulight::Module::wait(const QList<QStringList> &iports, int msToWait, int msToSleep)
+bool modulight::Module::writeSharedMemory(OutputPort &op, message_t &msg)
 {
-    if (_state != ModuleState::RUNNING)
-    {
-        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
-            error() << "Invalid wait call : the process is not running" << endl;
+    if (op.ringFailed)
         return false;
-    }
 
-    for (int i = 0; i < iports.size(); ++i)
+    // Retired rings are unlinked once no descriptor of theirs can be mapped anymore
+    for (int i = op.retiredRings.size() - 1; i >= 0; --i)
+        if (op.retiredRings[i]->isIdle())
+            op.retiredRings.removeAt(i);
+
+    if (op.ring.isNull() || op.ring->slotSize() < (qint64)msg.size())
     {
-        for (int j = 0; j < iports[i].size(); ++j)
+        // Readers still using the previous ring keep their own mapping of it
+        qint64 slotSize = op.ring.isNull() ? (qint64)msg.size() : qMax((qint64)msg.size(), 2 * op.ring->slotSize());
+        QString name = QString("/modulight-%1-%2-%3").arg(getpid()).arg(op.id).arg(++op.ringGeneration);
+        SharedMemoryRing * ring = SharedMemoryRing::create(name, slotSize);
+
+        if (!ring)
         {
-            if (!_inputPorts.contains(iports[i][j]))
-            {
-                error() << "Invalid wait call, no such input port (" << iports[i][j].toStdString() << ')' << endl;
-                return false;
-            }
+            error() << "Cannot create the shared memory ring of " << op.name.toStdString() << ", its messages are sent inline" << endl;
+            op.ring.clear();
+            op.ringFailed = true;
+            return false;
         }
-    }
 
-    // Converting ms to µs
-    if (msToSleep > 0)
-        msToSleep *= 1000;
-    else if (msToSleep < 0)
-        msToSleep = 1;
+        // Descriptors of the previous ring may still be on their way to readers which have not mapped it yet
+        if (!op.ring.isNull() && !op.ring->isIdle())
+            op.retiredRings.append(op.ring);
 
-    ++_iterationNumber;
+        op.ring = QSharedPointer<SharedMemoryRing>(ring);
+        op.lastSlot = -1;
 
-    if (msToWait <= -1)
-    {
-        while (true)
+        for (int i = 0; i < op.sharedMemoryReaders.size(); ++i)
         {
-            handleOnRequestSends();
-            updateMessageAvailability();
-
-            for (int i = 0; i < iports.size(); ++i)
-            {
-                bool ok = true;
-                for (int j = 0; j < iports[i].size(); ++j)
-                {
-                    if (!_inputPorts[iports[i][j]].messageAvailableOnLossless)
-                    {
-                        ok = false;
-                        break;
-                    }
-                }
-
-                if (ok)
-                    return true;
-            }
-
-            if (msToSleep != 0)
-                usleep(msToSleep);
+            const SharedMemoryReader & r = op.sharedMemoryReaders[i];
+            ring->addReader(r.id, r.lossless, r.active);
         }
     }
-    else if (msToWait == 0)
-    {
-        handleOnRequestSends();
-        updateMessageAvailability();
 
-        for (int i = 0; i < iports.size(); ++i)
-        {
-            bool ok = true;
-            for (int j = 0; j < iports[i].size(); ++j)
-            {
-                if (!_inputPorts[iports[i][j]].messageAvailableOnLossless)
-                {
-                    ok = false;
-                    break;
-                }
-            }
+    int slot;
+    QTime time;
+    time.start();
 
-            if (ok)
-                return true;
-        }
-    }
-    else
+    // Back-pressure : every slot is still used by a reader. A reader which does not release its slot in time gets the message inline,
+    // as well as the next ones until a slot is free again, so that a stalled reader does not hold every send back
+    while ((slot = op.ring->acquireSlot(op.lastSlot)) == -1)
     {
-        QTime time;
-        time.start();
-
-        while (time.elapsed() < msToWait)
+        if (op.ringStalled || time.elapsed() >= SharedMemoryRing::MAX_SLOT_WAIT)
         {
-            handleOnRequestSends();
-            updateMessageAvailability();
+            op.ringStalled = true;
+            return false;
+        }
 
-            for (int i = 0; i < iports.size(); ++i)
-            {
-                bool ok = true;
-                for (int j = 0; j < iports[i].size(); ++j)
-                {
-                    if (!_inputPorts[iports[i][j]].messageAvailableOnLossless)
-                    {
-                        ok = false;
-                        break;
-                    }
-                }
+        handleLossyPushes();
+        usleep(50);
+    }
 
-                if (ok)
-                    return true;
-            }
+    op.ringStalled = false;
 
-            if (msToSleep != 0)
-                usleep(msToSleep);
-        }
-    }
+    memcpy(op.ring->slotData(slot), msg.data(), msg.size());
+    op.ring->publishSlot(slot, ++op.ringSequence);
+    op.lastSlot = slot;
 
-    return false;
+    memset(&op.lastDescriptor, 0, sizeof(SharedMemoryDescriptor));
+    strncpy(op.lastDescriptor.ringName, op.ring->name().toUtf8().data(), sizeof(op.lastDescriptor.ringName) - 1);
+    op.lastDescriptor.slot = slot;
+    op.lastDescriptor.size = msg.size();
+    op.lastDescriptor.sequence = op.ringSequence;
+
+    return true;
 }
 
-bool modulight::Module::messageAvailable(const QString & iport)
+void modulight::Module::handleSharedMemorySubscriptions(OutputPort &op)
 {
-    if (_state != ModuleState::RUNNING)
-    {
-        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
-            error() << "Invalid messageAvailable call : the process is not running" << endl;
-        return false;
-    }
+    message_t subscription;
 
-    if (!_inputPorts.contains(iport))
+    // XPUB gives [1][topic] on subscription, [0][topic] on unsubscription.
+    // A subscription may arrive before the order which adds the reader, so subscribers are remembered
+    while (op.shmPub->recv(&subscription, ZMQ_DONTWAIT))
     {
-        error() << "Invalid messageAvailable call : no such port (" << iport.toStdString() << ")" << endl;
-        return false;
-    }
+        const char * data = (const char *) subscription.data();
+        quint32 id;
 
-    return _inputPorts[iport].messageAvailableOnLossless || _inputPorts[iport].messageAvailableOnLossy;
-}
+        if (subscription.size() != 2 + sizeof(quint32) || data[1] != 's')
+            continue;
 
-bool modulight::Module::messageAvailable(const QStringList &iports)
-{
-    if (_state != ModuleState::RUNNING)
-    {
-        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
-            error() << "Invalid messageAvailable call : the process is not running" << endl;
-        return false;
+        memcpy(&id, data + 2, sizeof(quint32));
+
+        if (data[0] == 1)
+            op.sharedMemorySubscribers.append(id);
+        else
+            op.sharedMemorySubscribers.removeOne(id);
     }
 
-    for (int i = 0; i < iports.size(); ++i)
+    for (int i = 0; i < op.sharedMemoryReaders.size(); ++i)
     {
-        if (!_inputPorts.contains(iports[i]))
+        SharedMemoryReader & r = op.sharedMemoryReaders[i];
+
+        if (!r.active && op.sharedMemorySubscribers.contains(r.id))
         {
-            error() << "Invalid messageAvailable call : no such port (" << iports[i].toStdString() << ")" << endl;
-            return false;
-        }
+            r.active = true;
 
-        if (!_inputPorts[iports[i]].messageAvailableOnLossless && !_inputPorts[iports[i]].messageAvailableOnLossy)
-            return false;
+            if (!op.ring.isNull())
+                op.ring->activateReader(r.id, op.ringSequence + 1);
+        }
     }
-
-    return true;
 }
 
-QStringList modulight::Module::portSources(const QString &port)
+void modulight::Module::addSharedMemoryReader(OutputPort &op, const QString &remoteName, quint32 remoteId, bool lossless)
 {
-    if (_state != ModuleState::RUNNING)
-    {
-        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
-            error() << "Invalid portSources call : the process is not running" << endl;
-        return QStringList();
-    }
+    SharedMemoryReader r;
 
-    return _inputPorts[port].losslessRemotes + _inputPorts[port].lossyRemotes;
-}
+    r.name = remoteName;
+    r.id = remoteId;
+    r.lossless = lossless;
+    r.active = !lossless; // Lossy remotes only receive descriptors once they have given a credit
 
-MPI_Comm modulight::Module::mpiWorld() const
-{
-    if (_state != ModuleState::RUNNING)
-    {
-        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
-            error() << "Invalid mpiWorld call : the process is not running" << endl;
-        return MPI_COMM_WORLD;
-    }
+    op.sharedMemoryReaders.append(r);
 
-    return _world;
+    if (!op.ring.isNull() && op.ring->addReader(r.id, r.lossless, r.active) == -1)
+        error() << "Too many co-located remotes on " << op.name.toStdString() << ", " << remoteName.toStdString()
+                << " will not receive its large messages" << endl;
+
+    handleSharedMemorySubscriptions(op);
 }
 
-void modulight::Module::send(const QString &port, const MessageWriter &writer)
+void modulight::Module::removeSharedMemoryReader(OutputPort &op, const QString &remoteName)
 {
-    if (_state != ModuleState::RUNNING)
-    {
-        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
-            error() << "Invalid send call : the process is not running" << endl;
-        return;
-    }
+    int index = op.sharedMemoryReaderIndex(remoteName);
 
-    if (_outputPorts.contains(port))
-    {
-        ++_outputPorts[port].iterationNumber;
-
-        Stamp stamp(true, &_outputPorts[port].completePortName, _iterationNumber,
-                    _outputPorts[port].iterationNumber);
+    if (index == -1)
+        return;
 
-        _outputPorts[port].pub->send(stamp.data(), stamp.size(), ZMQ_SNDMORE);
-        _outputPorts[port].pub->send(writer.data(), writer.size());
+    if (!op.ring.isNull())
+        op.ring->removeReader(op.sharedMemoryReaders[index].id);
 
-        if (!_outputPorts[port].lossyRemotes.isEmpty())
-        {
-            _outputPorts[port].lastMessageBuffer.resize(writer.size());
-            memcpy(_outputPorts[port].lastMessageBuffer.data(), writer.data(), writer.size());
+    for (int i = 0; i < op.retiredRings.size(); ++i)
+        op.retiredRings[i]->removeReader(op.sharedMemoryReaders[index].id);
 
-            _outputPorts[port].lastStamp = stamp;
+    op.sharedMemoryReaders.remove(index);
+}
 
-            QMutableMapIterator<QString, bool> it(_outputPorts[port].lossyRemotes);
-            while (it.hasNext())
-            {
-                it.next();
-                it.value() = false;
-            }
-        }
-    }
-    else
-    {
-        error() << "Invalid send call : no such port ("
-                << port.toStdString() << ")" << endl;
-    }
+void modulight::Module::subscribeToSharedMemory(InputPort &port)
+{
+    QByteArray topic = sharedMemoryTopic(port.id);
+    port.sub->setsockopt(ZMQ_SUBSCRIBE, topic.data(), topic.size());
 }
 
-void modulight::Module::send(const QString &port, const char *data, unsigned int size)
+bool modulight::Module::mapSharedMemoryMessage(InputPort &port, ReceivedMessage &message)
 {
-    if (_state != ModuleState::RUNNING)
+    SharedMemoryDescriptor descriptor;
+
+    if (!SharedMemoryDescriptor::fromData(message.message->data(), message.message->size(), descriptor))
     {
-        if (_state != ModuleState::RUNNING_WITHOUT_ENVIRONMENT)
-            error() << "Invalid send call : the process is not running" << endl;
-        return;
+        error() << "Critical coherence error within modulight : invalid shared memory descriptor received on " << port.name.toStdString() << endl;
+        return false;
     }
 
-    if (_outputPorts.contains(port))
-    {
-        ++_outputPorts[port].iterationNumber;
+    SharedMemorySource & source = port.sharedMemorySources[message.sourceId];
+    QString ringName = QString::fromUtf8(descriptor.ringName);
 
-        Stamp stamp(true, &_outputPorts[port].completePortName, _iterationNumber,
-                    _outputPorts[port].iterationNumber);
-        _outputPorts[port].pub->send(stamp.data(), stamp.size(), ZMQ_SNDMORE);
-        _outputPorts[port].pub->send(data, size);
+    // The producer creates a bigger ring once a message does not fit in its slots
+    if (source.ring.isNull() || source.ringName != ringName)
+    {
+        SharedMemoryRing * ring = SharedMemoryRing::open(ringName);
 
-        if (!_outputPorts[port].lossyRemotes.isEmpty())
+        if (!ring)
         {
-            _outputPorts[port].lastMessageBuffer.resize(size);
-            memcpy(_outputPorts[port].lastMessageBuffer.data(), data, size);
-
-            _outputPorts[port].lastStamp = stamp;
-
-            QMutableMapIterator<QString, bool> it(_outputPorts[port].lossyRemotes);
-            while (it.hasNext())
-            {
-                it.next();
-                it.value() = false;
-            }
+            error() << "Cannot map the shared memory ring \"" << ringName.toStdString() << "\" on " << port.name.toStdString() << endl;
+            return false;
         }
+
+        source.ringName = ringName;
+        source.ring = QSharedPointer<SharedMemoryRing>(ring);
+        source.reader = -1;
     }
-    else
+
+    if (source.reader == -1)
+        source.reader = source.ring->readerIndex(port.id);
+
+    if (source.reader == -1 || descriptor.slot < 0 || descriptor.slot >= SharedMemoryRing::SLOT_COUNT ||
+        descriptor.size < 0 || descriptor.size > source.ring->slotSize())
     {
-        error() << "Invalid send call : no such port ("
-                << port.toStdString() << ")" << endl;
+        error() << "Critical coherence error within modulight : invalid shared memory descriptor received on " << port.name.toStdString() << endl;
+        return false;
     }
+
+    // Descriptors published before the producer knew this port was subscribed do not hold their slot
+    if (!source.ring->isActive(source.reader, descriptor.sequence))
+        return false;
+
+    SharedMemorySlotHandle * handle = new SharedMemorySlotHandle;
+    handle->ring = source.ring;
+    handle->slot = descriptor.slot;
+    handle->reader = source.reader;
+
+    char * data = const_cast<char *>(source.ring->slotData(descriptor.slot));
+    message.message = QSharedPointer<message_t>(new message_t(data, descriptor.size, releaseSharedMemorySlot, handle));
+    message.inRing = true;
+
+    return true;
 }
 
 bool modulight::Module::isInputPortConnected(const QString &iport)
@@ -1214,9 +3736,13 @@ bool modulight::Module::isInputPortConnected(const QString &iport)
         return false;
     }
 
+    QMutexLocker locker(progressLock());
+
     checkDynamicOrders();
 
-    if (!_inputPorts.contains(iport))
+    PortHandle port = inputPort(iport);
+
+    if (!port.isValid())
     {
         error() << "Invalid isInputPortConnected call : no such port ("
                 << iport.toStdString() << ")" << endl;
@@ -1224,7 +3750,8 @@ bool modulight::Module::isInputPortConnected(const QString &iport)
         return false;
     }
 
-    return !_inputPorts[iport].losslessRemotes.isEmpty() || !_inputPorts[iport].lossyRemotes.isEmpty();
+    const InputPort & ip = _inputPorts[port._index];
+    return !ip.losslessRemotes.isEmpty() || !ip.lossyChannels.isEmpty();
 }
 
 bool modulight::Module::isOutputPortConnected(const QString &oport)
@@ -1236,9 +3763,13 @@ bool modulight::Module::isOutputPortConnected(const QString &oport)
         return false;
     }
 
+    QMutexLocker locker(progressLock());
+
     checkDynamicOrders();
 
-    if (!_outputPorts.contains(oport))
+    PortHandle port = outputPort(oport);
+
+    if (!port.isValid())
     {
         error() << "Invalid isOutputPortConnected call : no such port ("
                 << oport.toStdString() << ")" << endl;
@@ -1246,7 +3777,8 @@ bool modulight::Module::isOutputPortConnected(const QString &oport)
         return false;
     }
 
-    return !_outputPorts[oport].losslessRemotes.isEmpty() || !_outputPorts[oport].lossyRemotes.isEmpty();
+    const OutputPort & op = _outputPorts[port._index];
+    return !op.losslessRemotes.isEmpty() || !op.lossyRemotes.isEmpty() || !op.boundedRemotes.isEmpty();
 }
 
 QString modulight::Module::xmlDescription() const
@@ -1257,22 +3789,26 @@ QString modulight::Module::xmlDescription() const
     description.ip = _ip;
     description.syncPort = _syncRepPort;
 
-    QMapIterator<QString, InputPort> itIn(_inputPorts);
-    while (itIn.hasNext())
+    for (int i = 0; i < _inputPorts.size(); ++i)
     {
-        itIn.next();
-        description.inputPorts.append(itIn.key());
+        description.inputPorts.append(_inputPorts[i].name);
+
+        if (_inputPorts[i].steeringSub)
+            description.steeringInputPorts.append(_inputPorts[i].name);
     }
 
-    QMapIterator<QString, OutputPort> itOut(_outputPorts);
-    while (itOut.hasNext())
+    for (int i = 0; i < _outputPorts.size(); ++i)
     {
-        itOut.next();
-
         ModuleDescription::OutputPort o;
-        o.losslessPort = itOut.value().pubPort;
-        o.lossyPort = itOut.value().repPort;
-        description.outputPorts[itOut.key()] = o;
+        o.losslessPort = _outputPorts[i].pubPort;
+        o.lossyPort = _outputPorts[i].routerPort;
+        o.losslessIpc = _outputPorts[i].pubIpc;
+        o.lossyIpc = _outputPorts[i].routerIpc;
+        o.sharedMemoryIpc = _outputPorts[i].shmPubIpc;
+        o.steeringPort = _outputPorts[i].steeringPort;
+        o.steeringIpc = _outputPorts[i].steeringIpc;
+        o.index = i;
+        description.outputPorts[_outputPorts[i].name] = o;
     }
 
     QString s;
@@ -1291,45 +3827,47 @@ void modulight::Module::sendDescription()
 
 void modulight::Module::receiveInstanceInformation()
 {
-    MPI_Recv(&_instanceNumber, 1, MPI_INT, 0, tag::INSTANCE_INFO, _parent, MPI_STATUS_IGNORE);
+    int info[2];
+    MPI_Recv(info, 2, MPI_INT, 0, tag::INSTANCE_INFO, _parent, MPI_STATUS_IGNORE);
+
+    _instanceNumber = info[0];
+    _processId = info[1];
 }
 
 void modulight::Module::createPollItems()
 {
-    _pollItems.resize(_inputPorts.size() * 2);
+    // Each input port SUB socket is followed by its steering lane SUB socket, if any, then by its lossy channels sockets.
+    // Output ports ROUTER sockets come last, they are polled to wake blocking waits up as soon as a lossy credit arrives.
+    // Poll items are created again each time a lossy channel is added or removed
+    _pollItems.clear();
 
-    QMutableMapIterator<QString, InputPort> it(_inputPorts);
-    for (int i = 0; it.hasNext(); ++i)
+    for (int i = 0; i < _inputPorts.size(); ++i)
     {
-        it.next();
-
-        _pollItems[2*i  ].socket = *it.value().sub;
-        _pollItems[2*i  ].events = ZMQ_POLLIN;
+        _pollItems.append(pollItem(*_inputPorts[i].sub));
 
-        _pollItems[2*i+1].socket = *it.value().req;
-        _pollItems[2*i+1].events = ZMQ_POLLIN;
+        if (_inputPorts[i].steeringSub)
+            _pollItems.append(pollItem(*_inputPorts[i].steeringSub));
 
-        it.value().messageAvailableOnLossless = false;
-        it.value().messageAvailableOnLossy = false;
+        for (int j = 0; j < _inputPorts[i].lossyChannels.size(); ++j)
+            _pollItems.append(pollItem(*_inputPorts[i].lossyChannels[j].dealer));
     }
+
+    for (int i = 0; i < _outputPorts.size(); ++i)
+        _pollItems.append(pollItem(*_outputPorts[i].router));
 }
 
 void modulight::Module::fillCompletePortNames()
 {
-    QMutableMapIterator<QString, InputPort> itIn(_inputPorts);
-    while (itIn.hasNext())
+    for (int i = 0; i < _inputPorts.size(); ++i)
     {
-        itIn.next();
-
-        itIn.value().completePortName = QString("%1%2:%3").arg(_name).arg(_instanceNumber).arg(itIn.key()).toUtf8();
+        _inputPorts[i].completePortName = QString("%1%2:%3").arg(_name).arg(_instanceNumber).arg(_inputPorts[i].name).toUtf8();
+        _inputPorts[i].id = inputPortId(_processId, i);
     }
 
-    QMutableMapIterator<QString, OutputPort> itOut(_outputPorts);
-    while (itOut.hasNext())
+    for (int i = 0; i < _outputPorts.size(); ++i)
     {
-        itOut.next();
-
-        itOut.value().completePortName = QString("%1%2:%3").arg(_name).arg(_instanceNumber).arg(itOut.key()).toUtf8();
+        _outputPorts[i].completePortName = QString("%1%2:%3").arg(_name).arg(_instanceNumber).arg(_outputPorts[i].name).toUtf8();
+        _outputPorts[i].id = outputPortId(_processId, i);
     }
 }
 
@@ -1393,22 +3931,39 @@ void modulight::Module::handleSequence(const Sequence & seq)
     {
         if (c[i].isConnect)
         {
-            QString remote = QString("tcp://%1:%2").arg(c[i].remoteIP).arg(c[i].remotePort);
-            QByteArray qbaRemote = remote.toUtf8();
+            QByteArray qbaRemote = remoteEndpoint(c[i].remoteIP, c[i].remotePort, c[i].remoteIpc);
 
             //display() << "Connecting " << c[i].localPortName.toStdString() << " to " << qbaRemote.data() << endl;
 
-            if (c[i].isLossy)
+            int portIndex = orderedPortIndex(_inputPortIndexes, c[i].localPortName);
+
+            if (portIndex == -1)
+                continue;
+
+            InputPort & port = _inputPorts[portIndex];
+            _sourceNames[c[i].remoteId] = c[i].remoteAbbrevName;
+
+            if (c[i].isLossy || c[i].queueBound > 0)
             {
-                _inputPorts[c[i].localPortName].req->connect(qbaRemote.data());
-                _inputPorts[c[i].localPortName].lossyRemotes.append(c[i].remoteAbbrevName);
+                // The remote does not read its credits before the application is started,
+                // by which time it knows this port
+                addLossyChannel(port, c[i].remoteAbbrevName, qbaRemote);
+                sendFirstCredit(*port.lossyChannels.last().dealer, c[i].queueBound);
             }
             else
             {
-                _inputPorts[c[i].localPortName].sub->connect(qbaRemote.data());
-                _inputPorts[c[i].localPortName].losslessRemotes.append(c[i].remoteAbbrevName);
+                if (c[i].isSharedMemory)
+                    subscribeToSharedMemory(port);
+
+                port.sub->connect(qbaRemote.data());
+                port.losslessRemotes.append(c[i].remoteAbbrevName);
             }
 
+            connectSteeringLane(port, c[i].remoteAbbrevName, c[i].remoteIP, c[i].steeringPort, c[i].steeringIpc);
+
+            if (c[i].msTimeToLive > 0)
+                port.timeToLive[c[i].remoteId] = c[i].msTimeToLive;
+
             /*socket_t req(_context, ZMQ_REQ);
 
             QByteArray qbaSync = QString("tcp://%1:%2").arg(c[i].remoteIP).arg(c[i].syncPort).toUtf8();
@@ -1420,10 +3975,24 @@ void modulight::Module::handleSequence(const Sequence & seq)
         }
         else
         {
+            int portIndex = orderedPortIndex(_outputPortIndexes, c[i].localPortName);
+
+            if (portIndex == -1)
+                continue;
+
+            OutputPort & port = _outputPorts[portIndex];
+
             if (c[i].isLossy)
-                _outputPorts[c[i].localPortName].lossyRemotes[c[i].remoteAbbrevName] = true;
+                port.addLossyRemote(c[i].remoteAbbrevName, c[i].remoteId, c[i].isSharedMemory, c[i].msTimeToLive,
+                                    Sampler(c[i].decimation, c[i].maxFrequency));
+            else if (c[i].queueBound > 0)
+                port.addBoundedRemote(c[i].remoteAbbrevName, c[i].remoteId, c[i].queueBound, c[i].queuePolicy, c[i].msTimeToLive,
+                                      Sampler(c[i].decimation, c[i].maxFrequency));
             else
-                _outputPorts[c[i].localPortName].losslessRemotes.append(c[i].remoteAbbrevName);
+                port.losslessRemotes.append(c[i].remoteAbbrevName);
+
+            if (c[i].isSharedMemory)
+                addSharedMemoryReader(port, c[i].remoteAbbrevName, c[i].remoteId, !c[i].isLossy);
 
             /*message_t msg;
             _syncRep.recv(&msg);
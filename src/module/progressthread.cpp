@@ -0,0 +1,24 @@
+#include <modulight/module/progressthread.hpp>
+
+#include <modulight/module.hpp>
+
+modulight::ProgressThread::ProgressThread(Module *module, int msPeriod) :
+    _module(module),
+    _msPeriod(msPeriod),
+    _stopRequested(0)
+{
+}
+
+void modulight::ProgressThread::stop()
+{
+    _stopRequested.store(1);
+}
+
+void modulight::ProgressThread::run()
+{
+    while (!_stopRequested.load())
+    {
+        _module->progress(_msPeriod);
+        msleep(_msPeriod);
+    }
+}
@@ -0,0 +1,38 @@
+#include <modulight/module/sendqueue.hpp>
+
+modulight::SendQueue::~SendQueue()
+{
+    Message * message = _head.load();
+
+    while (message)
+    {
+        Message * next = message->next;
+        delete message;
+        message = next;
+    }
+}
+
+void modulight::SendQueue::push(Message *message)
+{
+    Message * head = _head.load(std::memory_order_relaxed);
+
+    do
+        message->next = head;
+    while (!_head.compare_exchange_weak(head, message, std::memory_order_release, std::memory_order_relaxed));
+}
+
+modulight::SendQueue::Message * modulight::SendQueue::takeAll()
+{
+    Message * message = _head.exchange(0, std::memory_order_acquire);
+    Message * reversed = 0;
+
+    while (message)
+    {
+        Message * next = message->next;
+        message->next = reversed;
+        reversed = message;
+        message = next;
+    }
+
+    return reversed;
+}
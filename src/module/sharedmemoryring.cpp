@@ -0,0 +1,275 @@
+#include <modulight/module/sharedmemoryring.hpp>
+
+#include <cstring>
+#include <limits>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const quint32 RING_MAGIC = 0x6d6c7372; // "mlsr"
+static const qint64 INACTIVE = std::numeric_limits<qint64>::max();
+
+bool modulight::SharedMemoryDescriptor::fromData(const void *data, size_t size, SharedMemoryDescriptor &descriptor)
+{
+    if (size != sizeof(SharedMemoryDescriptor))
+        return false;
+
+    memcpy(&descriptor, data, sizeof(SharedMemoryDescriptor));
+    descriptor.ringName[sizeof(descriptor.ringName) - 1] = '\0';
+    return true;
+}
+
+modulight::SharedMemoryRing::SharedMemoryRing() :
+    _owner(false),
+    _header(0),
+    _slots(0),
+    _slotSize(0)
+{
+}
+
+modulight::SharedMemoryRing::~SharedMemoryRing()
+{
+    if (_slots)
+        munmap(_slots, SLOT_COUNT * _slotSize);
+
+    if (_header)
+        munmap(_header, headerSize());
+
+    if (_owner)
+        shm_unlink(_name.toUtf8().data());
+}
+
+size_t modulight::SharedMemoryRing::headerSize()
+{
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+
+    return ((sizeof(Header) + pageSize - 1) / pageSize) * pageSize;
+}
+
+modulight::SharedMemoryRing * modulight::SharedMemoryRing::create(const QString &name, qint64 slotSize)
+{
+    QByteArray qbaName = name.toUtf8();
+
+    // A segment left by a crashed process which had the same pid is replaced
+    shm_unlink(qbaName.data());
+
+    int fd = shm_open(qbaName.data(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+    if (fd == -1)
+        return 0;
+
+    if (ftruncate(fd, headerSize() + SLOT_COUNT * slotSize) == -1)
+    {
+        close(fd);
+        shm_unlink(qbaName.data());
+        return 0;
+    }
+
+    SharedMemoryRing * ring = new SharedMemoryRing;
+    ring->_name = name;
+    ring->_slotSize = slotSize;
+
+    if (!ring->map(fd, true))
+    {
+        delete ring;
+        shm_unlink(qbaName.data());
+        return 0;
+    }
+
+    Header * h = new (ring->_header) Header;
+
+    h->slotCount = SLOT_COUNT;
+    h->slotSize = slotSize;
+
+    for (int i = 0; i < SLOT_COUNT; ++i)
+    {
+        h->sequences[i].store(-1);
+        h->masks[i].store(0);
+    }
+
+    for (int i = 0; i < MAX_READERS; ++i)
+    {
+        h->readers[i].inputPortId.store(0);
+        h->readers[i].lossless.store(0);
+        h->readers[i].activeSince.store(INACTIVE);
+    }
+
+    h->magic = RING_MAGIC;
+    ring->_owner = true;
+
+    return ring;
+}
+
+modulight::SharedMemoryRing * modulight::SharedMemoryRing::open(const QString &name)
+{
+    int fd = shm_open(name.toUtf8().data(), O_RDWR, 0);
+
+    if (fd == -1)
+        return 0;
+
+    SharedMemoryRing * ring = new SharedMemoryRing;
+    ring->_name = name;
+
+    if (!ring->map(fd, false))
+    {
+        delete ring;
+        return 0;
+    }
+
+    return ring;
+}
+
+bool modulight::SharedMemoryRing::map(int fd, bool owner)
+{
+    void * header = mmap(0, headerSize(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (header == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+
+    _header = static_cast<Header *>(header);
+
+    if (!owner)
+    {
+        struct stat st;
+
+        if (_header->magic != RING_MAGIC || fstat(fd, &st) == -1 ||
+            st.st_size != (off_t)(headerSize() + SLOT_COUNT * _header->slotSize))
+        {
+            close(fd);
+            return false;
+        }
+
+        _slotSize = _header->slotSize;
+    }
+
+    int protection = owner ? PROT_READ | PROT_WRITE : PROT_READ;
+    void * slots = mmap(0, SLOT_COUNT * _slotSize, protection, MAP_SHARED, fd, headerSize());
+
+    // The mappings remain valid once the descriptor is closed
+    close(fd);
+
+    if (slots == MAP_FAILED)
+        return false;
+
+    _slots = static_cast<char *>(slots);
+    return true;
+}
+
+int modulight::SharedMemoryRing::addReader(quint32 inputPortId, bool lossless, bool active)
+{
+    int index = readerIndex(inputPortId);
+
+    for (int i = 0; i < MAX_READERS && index == -1; ++i)
+        if (_header->readers[i].inputPortId.load() == 0)
+            index = i;
+
+    if (index == -1)
+        return -1;
+
+    Reader & r = _header->readers[index];
+
+    r.lossless.store(lossless ? 1 : 0);
+    r.activeSince.store(active ? 0 : INACTIVE);
+    r.inputPortId.store(inputPortId);
+
+    return index;
+}
+
+void modulight::SharedMemoryRing::activateReader(quint32 inputPortId, qint64 sequence)
+{
+    int index = readerIndex(inputPortId);
+
+    if (index != -1 && _header->readers[index].activeSince.load() == INACTIVE)
+        _header->readers[index].activeSince.store(sequence);
+}
+
+void modulight::SharedMemoryRing::removeReader(quint32 inputPortId)
+{
+    int index = readerIndex(inputPortId);
+
+    if (index == -1)
+        return;
+
+    _header->readers[index].inputPortId.store(0);
+
+    for (int i = 0; i < SLOT_COUNT; ++i)
+        _header->masks[i].fetch_and(~(1u << index));
+}
+
+int modulight::SharedMemoryRing::acquireSlot(int previousSlot) const
+{
+    for (int k = 1; k <= SLOT_COUNT; ++k)
+    {
+        int slot = (previousSlot + k + SLOT_COUNT) % SLOT_COUNT;
+
+        if (_header->masks[slot].load() == 0)
+            return slot;
+    }
+
+    return -1;
+}
+
+char * modulight::SharedMemoryRing::slotData(int slot)
+{
+    return _slots + slot * _slotSize;
+}
+
+const char * modulight::SharedMemoryRing::slotData(int slot) const
+{
+    return _slots + slot * _slotSize;
+}
+
+void modulight::SharedMemoryRing::publishSlot(int slot, qint64 sequence)
+{
+    quint32 mask = 0;
+
+    for (int r = 0; r < MAX_READERS; ++r)
+    {
+        const Reader & reader = _header->readers[r];
+
+        if (reader.inputPortId.load() != 0 && reader.lossless.load() && reader.activeSince.load() <= sequence)
+            mask |= 1u << r;
+    }
+
+    _header->sequences[slot].store(sequence);
+    _header->masks[slot].store(mask);
+}
+
+void modulight::SharedMemoryRing::holdSlot(int slot, int reader)
+{
+    _header->masks[slot].fetch_or(1u << reader);
+}
+
+bool modulight::SharedMemoryRing::isIdle() const
+{
+    for (int i = 0; i < SLOT_COUNT; ++i)
+        if (_header->masks[i].load() != 0)
+            return false;
+
+    return true;
+}
+
+int modulight::SharedMemoryRing::readerIndex(quint32 inputPortId) const
+{
+    for (int i = 0; i < MAX_READERS; ++i)
+        if (_header->readers[i].inputPortId.load() == inputPortId)
+            return i;
+
+    return -1;
+}
+
+bool modulight::SharedMemoryRing::isActive(int reader, qint64 sequence) const
+{
+    return _header->readers[reader].activeSince.load() <= sequence;
+}
+
+void modulight::SharedMemoryRing::releaseSlot(int slot, int reader)
+{
+    _header->masks[slot].fetch_and(~(1u << reader));
+}
@@ -0,0 +1,80 @@
+#include <modulight/module/tokenbucket.hpp>
+
+#include <cmath>
+
+#include <QtGlobal>
+
+static const double BURST_SECONDS = 0.1;
+
+modulight::TokenBucket::TokenBucket() :
+    _messageRate(0),
+    _byteRate(0),
+    _messageTokens(0),
+    _byteTokens(0)
+{
+}
+
+void modulight::TokenBucket::setRate(double messagesPerSecond, double bytesPerSecond)
+{
+    _messageRate = qMax(0.0, messagesPerSecond);
+    _byteRate = qMax(0.0, bytesPerSecond);
+
+    // The buckets start full
+    _messageTokens = qMax(1.0, _messageRate * BURST_SECONDS);
+    _byteTokens = _byteRate * BURST_SECONDS;
+
+    _timer.start();
+}
+
+bool modulight::TokenBucket::consume(int size)
+{
+    if (msUntilAvailable(size) > 0)
+        return false;
+
+    refill();
+
+    _messageTokens -= 1;
+    _byteTokens -= size;
+
+    return true;
+}
+
+int modulight::TokenBucket::msUntilAvailable(int size) const
+{
+    double seconds = 0;
+
+    if (_messageRate > 0 && messageTokens() < 1)
+        seconds = (1 - messageTokens()) / _messageRate;
+
+    if (_byteRate > 0)
+    {
+        double needed = qMin((double)size, _byteRate * BURST_SECONDS);
+
+        if (byteTokens() < needed)
+            seconds = qMax(seconds, (needed - byteTokens()) / _byteRate);
+    }
+
+    return (int) std::ceil(seconds * 1000);
+}
+
+double modulight::TokenBucket::messageTokens() const
+{
+    double elapsed = _timer.nsecsElapsed() / 1e9;
+
+    return qMin(qMax(1.0, _messageRate * BURST_SECONDS), _messageTokens + elapsed * _messageRate);
+}
+
+double modulight::TokenBucket::byteTokens() const
+{
+    double elapsed = _timer.nsecsElapsed() / 1e9;
+
+    return qMin(_byteRate * BURST_SECONDS, _byteTokens + elapsed * _byteRate);
+}
+
+void modulight::TokenBucket::refill()
+{
+    _messageTokens = messageTokens();
+    _byteTokens = byteTokens();
+
+    _timer.start();
+}